@@ -0,0 +1,211 @@
+//+----------------------------------------------------+
+//| Author: Maxim Ulyanov <ulyanov.maxim@gmail.com>    |
+//+----------------------------------------------------+
+#include <chrono>
+#include <iostream>
+#include <sstream>
+#include <random>
+#include <string>
+#include <algorithm>
+#include <vector>
+#include <queue>
+#include <memory>
+#include <functional>
+//---
+#include "../sort/LoserTree.h"
+//---
+using namespace std;
+//+----------------------------------------------------+
+//| ,                                          |
+//+----------------------------------------------------+
+class CTimer
+  {
+private:
+   chrono::time_point<chrono::high_resolution_clock> m_start;
+
+public:
+   void              Start() { m_start = chrono::high_resolution_clock::now(); }
+   long long         End() { auto end = chrono::high_resolution_clock::now(); return( chrono::duration_cast<chrono::milliseconds>( end - m_start ).count() ); }
+  };
+//+----------------------------------------------------+
+//|                         |
+//+----------------------------------------------------+
+template<class IntType>
+struct SRun
+  {
+   vector<IntType>   data;
+   size_t            current;
+  };
+//+----------------------------------------------------+
+//|      CDataChunkItem   |
+//+----------------------------------------------------+
+template<class IntType>
+class CRunItem
+  {
+private:
+   IntType           m_item;
+   weak_ptr<SRun<IntType>> m_run;
+
+public:
+                     CRunItem( shared_ptr<SRun<IntType>> run ) : m_item( 0 ), m_run( run ) {}
+   bool              operator>( const CRunItem<IntType> &item ) const { return( m_item > item.m_item ); }
+   IntType           Item() const { return( m_item ); }
+   bool              Next()
+     {
+      if( m_run.expired() )
+         return( false );
+      shared_ptr<SRun<IntType>> run( m_run.lock() );
+      if( run->current >= run->data.size() )
+         return( false );
+      m_item = run->data[run->current++];
+      return( true );
+     }
+  };
+//+----------------------------------------------------+
+//|                       |
+//+----------------------------------------------------+
+template<class IntType>
+vector<shared_ptr<SRun<IntType>>> generate_runs( const size_t runs_count, const size_t run_size )
+  {
+   default_random_engine rnd( 12345 );
+   uniform_int_distribution<IntType> dist( numeric_limits<IntType>::min(), numeric_limits<IntType>::max() );
+   vector<shared_ptr<SRun<IntType>>> runs;
+   for( size_t run_index = 0; run_index < runs_count; run_index++ )
+     {
+      shared_ptr<SRun<IntType>> run( new SRun<IntType> );
+      run->data.resize( run_size );
+      for( auto &item : run->data )
+         item = dist( rnd );
+      sort( run->data.begin(), run->data.end() );
+      run->current = 0;
+      runs.push_back( run );
+     }
+   return( runs );
+  }
+//+----------------------------------------------------+
+//|      weak_ptr         |
+//+----------------------------------------------------+
+template<class IntType>
+void merge_heap( vector<shared_ptr<SRun<IntType>>> &runs, vector<IntType> &output )
+  {
+   priority_queue<CRunItem<IntType>, vector<CRunItem<IntType>>, greater<CRunItem<IntType>>> items;
+   for( const auto &run : runs )
+     {
+      run->current = 0;
+      CRunItem<IntType> item( run );
+      if( item.Next() )
+         items.push( item );
+     }
+   output.clear();
+   while( !items.empty() )
+     {
+      CRunItem<IntType> item = items.top();
+      items.pop();
+      output.push_back( item.Item() );
+      if( item.Next() )
+         items.push( item );
+     }
+  }
+//+----------------------------------------------------+
+//|                           |
+//+----------------------------------------------------+
+template<class IntType>
+void merge_loser_tree( vector<shared_ptr<SRun<IntType>>> &runs, vector<IntType> &output )
+  {
+   CLoserTree<IntType> tree;
+   tree.Init( runs.size() );
+   for( size_t run_index = 0; run_index < runs.size(); run_index++ )
+     {
+      runs[run_index]->current = 0;
+      if( !runs[run_index]->data.empty() )
+         tree.Set( run_index, runs[run_index]->data[runs[run_index]->current++] );
+     }
+   tree.Build();
+   output.clear();
+   while( !tree.Empty() )
+     {
+      output.push_back( tree.Top() );
+      SRun<IntType> &run = *runs[tree.TopSource()];
+      if( run.current < run.data.size() )
+         tree.Replace( run.data[run.current++] );
+      else
+         tree.Pop();
+     }
+  }
+//+----------------------------------------------------+
+//|                                |
+//+----------------------------------------------------+
+template<class IntType>
+bool benchmark( const size_t runs_count, const size_t run_size )
+  {
+   vector<shared_ptr<SRun<IntType>>> runs = generate_runs<IntType>( runs_count, run_size );
+   vector<IntType> heap_output, tree_output;
+   heap_output.reserve( runs_count * run_size );
+   tree_output.reserve( runs_count * run_size );
+   CTimer timer;
+//---   
+   timer.Start();
+   merge_heap( runs, heap_output );
+   long long heap_ms = timer.End();
+//---  
+   timer.Start();
+   merge_loser_tree( runs, tree_output );
+   long long tree_ms = timer.End();
+//---   
+   if( heap_output != tree_output || !is_sorted( tree_output.begin(), tree_output.end() ) )
+     {
+      cerr << "merge results differ" << endl;
+      return( false );
+     }
+   const double elements = double( runs_count * run_size );
+   cout << "runs " << runs_count << ", elements " << runs_count * run_size << endl;
+   cout << '\t' << "priority queue: " << heap_ms << " ms, " << ( heap_ms > 0 ? elements / heap_ms / 1000 : 0 ) << " M elements/s" << endl;
+   cout << '\t' << "loser tree:     " << tree_ms << " ms, " << ( tree_ms > 0 ? elements / tree_ms / 1000 : 0 ) << " M elements/s" << endl;
+   return( true );
+  }
+//+----------------------------------------------------+
+//|                     |
+//+----------------------------------------------------+
+bool parameters( const char* runs_count_arg, const char* run_size_arg, size_t &runs_count, size_t &run_size )
+  {
+   if( runs_count_arg == NULL || run_size_arg == NULL )
+      return( false );
+   stringstream runs_count_s( runs_count_arg ), run_size_s( run_size_arg );
+   runs_count_s >> runs_count;
+   run_size_s >> run_size;
+   return( !runs_count_s.fail() && !run_size_s.fail() && runs_count > 0 );
+  }
+//+----------------------------------------------------+
+//|                                    |
+//+----------------------------------------------------+
+void usage()
+  {
+   cout << "Usage: bench <runs_count> <run_size>" << endl;
+   cout << '\t' << "runs_count - number of sorted runs to merge (f.e. 256)" << endl;
+   cout << '\t' << "run_size - number of 32bit integers in each run (f.e. 65536)" << endl;
+  }
+//+----------------------------------------------------+
+//|                                          |
+//+----------------------------------------------------+
+int main(int argc,char** argv)
+  {
+//---  
+   if( argc != 3 )
+     {
+      cerr << "invalid parameters" << endl;
+      usage();
+      return( -1 );
+     }
+   size_t runs_count = 0, run_size = 0;
+   if( !parameters( argv[1], argv[2], runs_count, run_size ) )
+     {
+      cerr << "failed to read parameters" << endl;
+      return( -1 );
+     }
+//--- 
+   if( !benchmark<unsigned>( runs_count, run_size ) )
+      return( -1 );
+//--- ok
+   return(0);
+  }
+//+----------------------------------------------------+
@@ -5,70 +5,349 @@
 #include <iostream>
 #include <sstream>
 #include <fstream>
-#include <random>
 #include <string>
+#include <vector>
+#include <algorithm>
+#include <limits>
+#include <type_traits>
+#include <thread>
+#include <atomic>
+#include <functional>
+#include <stdint.h>
+#include <math.h>
+#include <time.h>
+#ifdef __linux__
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
 //--- 
 using namespace std;
 //--- 
 const long long KB = 1024;
 const long long MB = 1024 * KB;
 const long long GB = 1024 * MB;
+//--- unit of generation and writing: every block has its own random stream and is written at its own offset
+const long long BLOCK_SIZE = 4 * MB;
 //+----------------------------------------------------+
-//| Generate random file                               |
+//| xoshiro256** random engine                         |
 //+----------------------------------------------------+
-template<class IntType>
-void generate_random_file( const string &file_name, const size_t file_size )
+class CXoshiro256
   {
-//--- open the output file
-   ofstream fout;
-   fout.open( file_name, ios_base::out | ios_base::binary );
-   if( !fout )
+public:
+   typedef uint64_t  result_type;
+
+private:
+   uint64_t          m_state[4];
+
+public:
+   //--- stream of the seed: the state is expanded by splitmix64, so streams of one seed do not correlate
+                     CXoshiro256( const uint64_t seed, const uint64_t stream );
+   static result_type min() { return( 0 ); }
+   static result_type max() { return( numeric_limits<result_type>::max() ); }
+   result_type       operator()();
+   //--- uniform double in [0, 1)
+   double            Unit() { return( ( operator()() >> 11 ) * ( 1.0 / 9007199254740992.0 ) ); }
+
+private:
+   static uint64_t   Rotate( const uint64_t value, const int bits ) { return( ( value << bits ) | ( value >> ( 64 - bits ) ) ); }
+  };
+//+----------------------------------------------------+
+//| Constructor                                        |
+//+----------------------------------------------------+
+CXoshiro256::CXoshiro256( const uint64_t seed, const uint64_t stream )
+  {
+   uint64_t splitmix = seed + stream * 0xD1B54A32D192ED03ull;
+   for( int index = 0; index < 4; index++ )
      {
-      cerr << "failed to open output file " << file_name << endl;
+      uint64_t value = ( splitmix += 0x9E3779B97F4A7C15ull );
+      value = ( value ^ ( value >> 30 ) ) * 0xBF58476D1CE4E5B9ull;
+      value = ( value ^ ( value >> 27 ) ) * 0x94D049BB133111EBull;
+      m_state[index] = value ^ ( value >> 31 );
+     }
+  }
+//+----------------------------------------------------+
+//| Next random number                                 |
+//+----------------------------------------------------+
+CXoshiro256::result_type CXoshiro256::operator()()
+  {
+   const uint64_t result = Rotate( m_state[1] * 5, 7 ) * 9;
+   const uint64_t shifted = m_state[1] << 17;
+   m_state[2] ^= m_state[0];
+   m_state[3] ^= m_state[1];
+   m_state[1] ^= m_state[2];
+   m_state[0] ^= m_state[3];
+   m_state[2] ^= shifted;
+   m_state[3] = Rotate( m_state[3], 45 );
+   return( result );
+  }
+//+----------------------------------------------------+
+//| Key distribution                                   |
+//+----------------------------------------------------+
+enum EnDistribution
+  {
+   DIST_UNIFORM = 0,
+   DIST_SORTED,
+   DIST_REVERSE,
+   DIST_FEW,
+   DIST_ZIPF,
+   DIST_NOISY
+  };
+//+----------------------------------------------------+
+//| Generator parameters                               |
+//+----------------------------------------------------+
+struct SParameters
+  {
+   string            file_name;
+   size_t            file_size;
+   string            type;
+   EnDistribution    distribution;
+   //--- seed of the random engine, the same seed gives the same file with any number of threads
+   uint64_t          seed;
+   unsigned          threads;
+   //--- number of distinct keys for few and zipf, zipf exponent, share of random keys in noisy sorted data
+   size_t            distinct;
+   double            skew;
+   double            noise;
+                     SParameters() : file_size( 0 ), type( "u32" ), distribution( DIST_UNIFORM ), seed( (uint64_t) time( nullptr ) ), threads( max( 1u, thread::hardware_concurrency() ) ), distinct( 1024 ), skew( 1.0 ), noise( 0.01 ) {}
+  };
+//+----------------------------------------------------+
+//| Key generator                                      |
+//+----------------------------------------------------+
+template<class IntType>
+class CKeyGenerator
+  {
+private:
+   const SParameters &m_params;
+   const size_t      m_count;
+   //--- distinct keys for few and zipf in random order, cumulative zipf probabilities of their ranks
+   vector<IntType>   m_keys;
+   vector<double>    m_zipf;
+
+public:
+                     CKeyGenerator( const SParameters &params, const size_t count );
+   //--- key at the given position of the file; the generator is shared by threads, each with its own engine
+   IntType           Next( CXoshiro256 &rnd, const size_t index ) const;
+   uint64_t          Seed() const { return( m_params.seed ); }
+
+private:
+   //--- integers over the whole range, floats over half of it on either side of zero
+   static IntType    Uniform( CXoshiro256 &rnd );
+   static IntType    RangeMin() { return( is_floating_point<IntType>::value ? numeric_limits<IntType>::lowest() / 2 : numeric_limits<IntType>::min() ); }
+   static IntType    RangeMax() { return( is_floating_point<IntType>::value ? numeric_limits<IntType>::max() / 2 : numeric_limits<IntType>::max() ); }
+   //--- key at the given fraction of the range, fraction in [0, 1)
+   static IntType    Scale( const long double fraction );
+  };
+//+----------------------------------------------------+
+//| Constructor                                        |
+//+----------------------------------------------------+
+template<class IntType>
+CKeyGenerator<IntType>::CKeyGenerator( const SParameters &params, const size_t count ) : m_params( params ), m_count( count )
+  {
+   if( params.distribution != DIST_FEW && params.distribution != DIST_ZIPF )
       return;
+//--- distinct keys are drawn uniformly from a stream of their own, so the most frequent zipf key is not always the smallest one
+   CXoshiro256 rnd( params.seed, numeric_limits<uint64_t>::max() );
+   m_keys.resize( params.distinct );
+   for( size_t key = 0; key < m_keys.size(); key++ )
+      m_keys[key] = Uniform( rnd );
+   if( params.distribution != DIST_ZIPF )
+      return;
+//--- probability of rank r is proportional to 1 / r^skew
+   m_zipf.resize( params.distinct );
+   double sum = 0;
+   for( size_t rank = 0; rank < m_zipf.size(); rank++ )
+     {
+      sum += 1.0 / pow( (double) ( rank + 1 ), params.skew );
+      m_zipf[rank] = sum;
      }
-//--- generate numbers
-   default_random_engine rnd( (unsigned) time( nullptr ) );
-   uniform_int_distribution<IntType> dist( std::numeric_limits<IntType>::min(), std::numeric_limits<IntType>::max() );
-   char buffer[4 * KB];
-   size_t buffer_size=0;
-   for(size_t i=0; i < file_size / sizeof(IntType); i++)
+   for( size_t rank = 0; rank < m_zipf.size(); rank++ )
+      m_zipf[rank] /= sum;
+  }
+//+----------------------------------------------------+
+//| Uniform key                                        |
+//+----------------------------------------------------+
+template<class IntType>
+IntType CKeyGenerator<IntType>::Uniform( CXoshiro256 &rnd )
+  {
+//--- random bits are already uniform over the whole integer range
+   if( !is_floating_point<IntType>::value )
+      return( (IntType) rnd() );
+//--- one draw scaled in double: uniform_real_distribution<long double> is several times slower than the rest of the generator
+   const double value = (double) RangeMin() + rnd.Unit() * ( (double) RangeMax() - (double) RangeMin() );
+   return( (IntType) value );
+  }
+//+----------------------------------------------------+
+//| Key at the given fraction of the range             |
+//+----------------------------------------------------+
+template<class IntType>
+IntType CKeyGenerator<IntType>::Scale( const long double fraction )
+  {
+   const long double value = (long double) RangeMin() + fraction * ( (long double) RangeMax() - (long double) RangeMin() );
+   return( value >= (long double) RangeMax() ? RangeMax() : (IntType) value );
+  }
+//+----------------------------------------------------+
+//| Next key                                           |
+//+----------------------------------------------------+
+template<class IntType>
+IntType CKeyGenerator<IntType>::Next( CXoshiro256 &rnd, const size_t index ) const
+  {
+   switch( m_params.distribution )
      {
-      *((IntType*)(buffer + buffer_size)) = dist( rnd );
-      buffer_size += sizeof(IntType);
-      if( buffer_size == sizeof( buffer ) )
+      case DIST_SORTED:
+         return( Scale( (long double) index / m_count ) );
+      case DIST_REVERSE:
+         return( Scale( (long double) ( m_count - 1 - index ) / m_count ) );
+      case DIST_FEW:
+         return( m_keys[rnd() % m_keys.size()] );
+      case DIST_ZIPF:
         {
-         fout.write( buffer, buffer_size );
-         buffer_size = 0;
+         //--- rank by inverting the cumulative distribution
+         const size_t rank = upper_bound( m_zipf.begin(), m_zipf.end(), rnd.Unit() ) - m_zipf.begin();
+         return( m_keys[min( rank, m_keys.size() - 1 )] );
         }
+      case DIST_NOISY:
+         //--- sorted data with a share of keys replaced by random ones
+         if( rnd.Unit() >= m_params.noise )
+            return( Scale( (long double) index / m_count ) );
+         return( Uniform( rnd ) );
+      default:
+         return( Uniform( rnd ) );
      }
-   if( buffer_size > 0 )
-      fout.write( buffer, buffer_size );
-   fout.close();
   }
 //+----------------------------------------------------+
-//| Parameters                                         |
+//| Output file shared by generating threads           |
 //+----------------------------------------------------+
-bool parameters( const char* file_name_arg, const char* file_size_arg, string &file_name, size_t &file_size )
+struct SOutput
+  {
+   string            file_name;
+#ifdef __linux__
+   int               handle;
+#endif
+   long long         data_size;
+   //--- next block to generate and error of any thread
+   atomic<long long> next_block;
+   atomic<bool>      failed;
+  };
+//+----------------------------------------------------+
+//| Write a block at its offset                        |
+//+----------------------------------------------------+
+#ifdef __linux__
+bool write_block( SOutput &output, fstream &, const char* data, const size_t data_size, const long long offset )
+  {
+   size_t total = 0;
+   while( total < data_size )
+     {
+      const ssize_t size = pwrite( output.handle, data + total, data_size - total, offset + total );
+      if( size < 0 && errno == EINTR )
+         continue;
+      if( size <= 0 )
+         return( false );
+      total += size;
+     }
+   return( true );
+  }
+#else
+bool write_block( SOutput &, fstream &file, const char* data, const size_t data_size, const long long offset )
+  {
+   file.seekp( offset );
+   file.write( data, data_size );
+   return( !file.fail() );
+  }
+#endif
+//+----------------------------------------------------+
+//| Generate blocks in one thread                      |
+//+----------------------------------------------------+
+template<class IntType>
+void generate_blocks( const CKeyGenerator<IntType> &generator, SOutput &output )
+  {
+//--- without positional writes every thread seeks in a stream of its own
+   fstream file;
+#ifndef __linux__
+   file.open( output.file_name, ios_base::in | ios_base::out | ios_base::binary );
+   if( !file )
+     {
+      output.failed = true;
+      return;
+     }
+#endif
+   vector<IntType> keys( BLOCK_SIZE / sizeof( IntType ) );
+   for( ;; )
+     {
+      const long long block = output.next_block++;
+      const long long offset = block * BLOCK_SIZE;
+      if( offset >= output.data_size || output.failed )
+         break;
+      //--- the stream and the keys of a block depend only on its number, not on the thread
+      CXoshiro256 rnd( generator.Seed(), block );
+      const size_t first = (size_t) ( offset / sizeof( IntType ) );
+      const size_t count = (size_t) ( min( BLOCK_SIZE, output.data_size - offset ) / sizeof( IntType ) );
+      for( size_t index = 0; index < count; index++ )
+         keys[index] = generator.Next( rnd, first + index );
+      if( !write_block( output, file, (const char*) &keys[0], count * sizeof( IntType ), offset ) )
+         output.failed = true;
+     }
+  }
+//+----------------------------------------------------+
+//| Generate random file                               |
+//+----------------------------------------------------+
+template<class IntType>
+void generate_random_file( const SParameters &params )
+  {
+   const chrono::steady_clock::time_point start = chrono::steady_clock::now();
+   SOutput output;
+   output.file_name = params.file_name;
+   output.data_size = (long long) ( params.file_size / sizeof( IntType ) * sizeof( IntType ) );
+   output.next_block = 0;
+   output.failed = false;
+//--- create the output file, threads write their blocks at their offsets
+#ifdef __linux__
+   output.handle = open( params.file_name.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0666 );
+   if( output.handle < 0 )
+#else
+   if( !ofstream( params.file_name, ios_base::out | ios_base::binary | ios_base::trunc ) )
+#endif
+     {
+      cerr << "failed to open output file " << params.file_name << endl;
+      return;
+     }
+//--- generate keys
+   const CKeyGenerator<IntType> generator( params, (size_t) ( output.data_size / sizeof( IntType ) ) );
+   vector<thread> threads;
+   for( unsigned thread_index = 0; thread_index < params.threads; thread_index++ )
+      threads.push_back( thread( generate_blocks<IntType>, cref( generator ), ref( output ) ) );
+   for( size_t thread_index = 0; thread_index < threads.size(); thread_index++ )
+      threads[thread_index].join();
+#ifdef __linux__
+   close( output.handle );
+#endif
+   if( output.failed )
+     {
+      cerr << "failed to write to output file " << params.file_name << endl;
+      return;
+     }
+   cout << "generated " << output.data_size / MB << " MB by " << params.threads << " threads in " << chrono::duration_cast<chrono::milliseconds>( chrono::steady_clock::now() - start ).count() << " ms" << endl;
+  }
+//+----------------------------------------------------+
+//| Size with an optional unit                         |
+//+----------------------------------------------------+
+bool size_parse( const string &size_arg, size_t &size )
   {
-   if( file_name_arg == NULL || file_size_arg == NULL )
-      return( false );
-//--- name
-   file_name = file_name_arg;
-//--- size
    string size_unit;
-   stringstream file_size_arg_s( file_size_arg );
-   file_size_arg_s >> file_size >> size_unit;
+   stringstream size_arg_s( size_arg );
+   if( !( size_arg_s >> size ) )
+      return( false );
+   size_arg_s >> size_unit;
    if( !size_unit.empty() )
      {
       if( size_unit.compare( "GB" )==0 )
-         file_size *= GB;
+         size *= GB;
       else
          if( size_unit.compare( "MB" )==0 )
-            file_size *= MB;
+            size *= MB;
          else
             if( size_unit.compare( "KB" )==0 )
-               file_size *= KB;
+               size *= KB;
             else
               {
                cerr << "invalid size unit";
@@ -78,13 +357,96 @@ bool parameters( const char* file_name_arg, const char* file_size_arg, string &f
    return( true );
   }
 //+----------------------------------------------------+
+//| Parameters                                         |
+//+----------------------------------------------------+
+bool parameters( const int argc, char** argv, SParameters &params )
+  {
+   vector<string> names;
+   for( int arg_index = 1; arg_index < argc; arg_index++ )
+     {
+      const string arg( argv[arg_index] );
+      //--- file name and size
+      if( arg.compare( 0, 2, "--" ) != 0 )
+        {
+         names.push_back( arg );
+         continue;
+        }
+      //--- every option has a value
+      if( arg_index + 1 >= argc )
+         return( false );
+      const string value( argv[++arg_index] );
+      stringstream value_s( value );
+      if( arg == "--type" )
+        {
+         params.type = value;
+         continue;
+        }
+      if( arg == "--dist" )
+        {
+         const char* distributions[] = { "uniform", "sorted", "reverse", "few", "zipf", "noisy" };
+         const size_t count = sizeof( distributions ) / sizeof( distributions[0] );
+         const size_t distribution = find( distributions, distributions + count, value ) - distributions;
+         if( distribution == count )
+            return( false );
+         params.distribution = (EnDistribution) distribution;
+         continue;
+        }
+      if( arg == "--seed" )
+        {
+         if( !( value_s >> params.seed ) )
+            return( false );
+         continue;
+        }
+      if( arg == "--threads" )
+        {
+         if( !( value_s >> params.threads ) || params.threads == 0 )
+            return( false );
+         continue;
+        }
+      if( arg == "--distinct" )
+        {
+         if( !( value_s >> params.distinct ) || params.distinct == 0 )
+            return( false );
+         continue;
+        }
+      if( arg == "--skew" )
+        {
+         if( !( value_s >> params.skew ) || params.skew <= 0 )
+            return( false );
+         continue;
+        }
+      if( arg == "--noise" )
+        {
+         if( !( value_s >> params.noise ) || params.noise < 0 || params.noise > 100 )
+            return( false );
+         params.noise /= 100;
+         continue;
+        }
+      //--- unknown option
+      return( false );
+     }
+   if( names.size() != 2 )
+      return( false );
+//--- name and size
+   params.file_name = names[0];
+   return( size_parse( names[1], params.file_size ) );
+  }
+//+----------------------------------------------------+
 //| Usage                                              |
 //+----------------------------------------------------+
 void usage()
   {
-   cout << "Usage: gen <file_name> <file_size>" << endl;
+   cout << "Usage: gen [options] <file_name> <file_size>" << endl;
    cout << '\t' << "file_name - name of the output file" << endl;
    cout << '\t' << "file_size - size of the output file (f.e. 256, 64KB, 512MB, 4GB)" << endl;
+   cout << "Options:" << endl;
+   cout << '\t' << "--type u32|u64|i32|i64|f32|f64 - key type: unsigned, signed integer or IEEE-754 float of 32 or 64 bits (default u32)" << endl;
+   cout << '\t' << "--dist uniform|sorted|reverse|few|zipf|noisy - key distribution: uniform random, ascending, descending, few distinct keys, zipf-skewed distinct keys or ascending with random noise (default uniform)" << endl;
+   cout << '\t' << "--seed <number> - seed of the random engine, the same seed and options give the same file with any number of threads (default current time)" << endl;
+   cout << '\t' << "--threads <number> - number of generating threads (default number of hardware threads)" << endl;
+   cout << '\t' << "--distinct <number> - number of distinct keys for few and zipf (default 1024)" << endl;
+   cout << '\t' << "--skew <exponent> - zipf exponent, key of rank r occurs in proportion to 1/r^skew (default 1.0)" << endl;
+   cout << '\t' << "--noise <percent> - share of random keys in noisy sorted data (default 1)" << endl;
   }
 //+----------------------------------------------------+
 //| Main function                                      |
@@ -92,21 +454,39 @@ void usage()
 int main(int argc,char** argv)
   {
 //--- input parameters
-   if( argc != 3 )
+   SParameters params;
+   if( !parameters( argc, argv, params ) )
      {
       cerr << "invalid parameters" << endl;
       usage();
       return( -1 );
      }
-   string file_name;
-   size_t file_size = 0;
-   if( !parameters( argv[1], argv[2], file_name, file_size ) )
-     {
-      cerr << "failed to read parameters" << endl;
-      return( -1 );
-     }
+//--- the seed is printed so that the file can be generated again
+   cout << "seed " << params.seed << endl;
 //--- generate random file
-   generate_random_file<unsigned>( file_name, file_size );
+   if( params.type == "u32" )
+      generate_random_file<uint32_t>( params );
+   else
+      if( params.type == "u64" )
+         generate_random_file<uint64_t>( params );
+      else
+         if( params.type == "i32" )
+            generate_random_file<int32_t>( params );
+         else
+            if( params.type == "i64" )
+               generate_random_file<int64_t>( params );
+            else
+               if( params.type == "f32" )
+                  generate_random_file<float>( params );
+               else
+                  if( params.type == "f64" )
+                     generate_random_file<double>( params );
+                  else
+                    {
+                     cerr << "invalid key type " << params.type << endl;
+                     usage();
+                     return( -1 );
+                    }
 //--- ok
    return(0);
   }
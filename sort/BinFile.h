@@ -12,7 +12,11 @@ public:
       MODE_NONE = 0,
       MODE_READ = 0x01,
       MODE_WRITE = 0x02,
-      MODE_TEMP = 0x04
+      MODE_TEMP = 0x04,
+      MODE_UPDATE = 0x08,
+      MODE_DIRECT = 0x10,
+      MODE_URING = 0x20,
+      MODE_MMAP = 0x40
      };
 
 private:
@@ -21,6 +25,9 @@ private:
    int               m_mode;
    //--- 
    FILE*             m_stream;
+   //---     
+   void*             m_map;
+   size_t            m_map_size;
 
 public:
    //--- /
@@ -35,13 +42,27 @@ public:
    //--- /  
    size_t            Read( char* buffer, const size_t buffer_size );
    size_t            Write( const char* buffer, const size_t buffer_size );
+   //--- /  ,    
+   size_t            ReadAt( char* buffer, const size_t buffer_size, const long long offset );
+   size_t            WriteAt( const char* buffer, const size_t buffer_size, const long long offset );
+   //---   
+   bool              Seek( const long long offset );
+   //---   
+   int               Handle();
+   //---   O_DIRECT   -   
+   void              DirectDisable();
+   //---   io_uring  -    
+   bool              UringDisable( const long long offset );
+   //---        ,   
+   bool              Map( const long long offset, const size_t length, const char* &data );
+   void              Unmap();
    //---  
    void              Remove() { Close(); if( !m_name.empty() ) remove( m_name.c_str() ); }
   };
 //+----------------------------------------------------+
 //|                                         |
 //+----------------------------------------------------+
-CBinFile::CBinFile() : m_mode( 0 ), m_stream( nullptr )
+CBinFile::CBinFile() : m_mode( 0 ), m_stream( nullptr ), m_map( nullptr ), m_map_size( 0 )
   {
   }
 //+----------------------------------------------------+
@@ -65,9 +86,37 @@ bool CBinFile::Open( const std::string &name, const int mode )
    if( mode & MODE_WRITE )
       if( mode & MODE_READ ) mode_str = "w+b";
       else
-         mode_str = "wSb";
+         if( mode & MODE_UPDATE ) mode_str = "r+b";
+         else
+            mode_str = "wSb";
    else
       mode_str = "rSb";
+#ifdef __linux__
+//--- O_DIRECT     ,    
+   if( mode & MODE_DIRECT )
+     {
+      int flags = O_RDONLY;
+      if( mode & MODE_WRITE )
+         flags = ( mode & MODE_READ ) ? O_RDWR | O_CREAT | O_TRUNC : ( mode & MODE_UPDATE ) ? O_RDWR : O_WRONLY | O_CREAT | O_TRUNC;
+      int fd = open( name.c_str(), flags | O_DIRECT, 0666 );
+      //---      O_DIRECT (tmpfs)
+      if( fd < 0 && errno == EINVAL )
+        {
+         m_mode &= ~MODE_DIRECT;
+         fd = open( name.c_str(), flags, 0666 );
+        }
+      if( fd < 0 )
+         return( false );
+      if( ( m_stream = fdopen( fd, mode_str ) ) == nullptr )
+        {
+         close( fd );
+         return( false );
+        }
+      return( true );
+     }
+#else
+   m_mode &= ~MODE_DIRECT;
+#endif
    if( ( m_stream = fopen( name.c_str(), mode_str) ) == nullptr )
       return( false );
 //--- 
@@ -78,6 +127,7 @@ bool CBinFile::Open( const std::string &name, const int mode )
 //+----------------------------------------------------+
 void CBinFile::Close()
   {
+   Unmap();
    if( m_stream != nullptr )
      {
       fclose( m_stream );
@@ -95,7 +145,10 @@ size_t CBinFile::Read( char* buffer, const size_t buffer_size )
       return( 0 );
    if( m_stream == nullptr )
       return( 0 );
-   return( fread( buffer, 1, buffer_size, m_stream ) );
+   DirectDisable();
+   const size_t size = fread( buffer, 1, buffer_size, m_stream );
+   CMetrics::Instance().BytesRead( size );
+   return( size );
   }
 //+----------------------------------------------------+
 //|                                         |
@@ -106,6 +159,159 @@ size_t CBinFile::Write( const char* buffer, const size_t buffer_size )
       return( 0 );
    if( m_stream == nullptr )
       return( 0 );
-   return( fwrite( buffer, 1, buffer_size, m_stream ) );
+   DirectDisable();
+   const size_t size = fwrite( buffer, 1, buffer_size, m_stream );
+   CMetrics::Instance().BytesWritten( size );
+   return( size );
+  }
+//+----------------------------------------------------+
+//|                                    |
+//+----------------------------------------------------+
+size_t CBinFile::ReadAt( char* buffer, const size_t buffer_size, const long long offset )
+  {
+   if( buffer == nullptr || buffer_size == 0 || m_stream == nullptr )
+      return( 0 );
+#ifdef __linux__
+//---      
+   size_t total = 0;
+   while( total < buffer_size )
+     {
+      const ssize_t size = pread( Handle(), buffer + total, buffer_size - total, offset + total );
+      if( size < 0 && errno == EINTR )
+         continue;
+      if( size <= 0 )
+         break;
+      total += size;
+     }
+   CMetrics::Instance().BytesRead( total );
+   return( total );
+#else
+   if( !Seek( offset ) )
+      return( 0 );
+   return( Read( buffer, buffer_size ) );
+#endif
+  }
+//+----------------------------------------------------+
+//|                                    |
+//+----------------------------------------------------+
+size_t CBinFile::WriteAt( const char* buffer, const size_t buffer_size, const long long offset )
+  {
+   if( buffer == nullptr || buffer_size == 0 || m_stream == nullptr )
+      return( 0 );
+#ifdef __linux__
+   size_t total = 0;
+   while( total < buffer_size )
+     {
+      const ssize_t size = pwrite( Handle(), buffer + total, buffer_size - total, offset + total );
+      if( size < 0 && errno == EINTR )
+         continue;
+      if( size <= 0 )
+         break;
+      total += size;
+     }
+   CMetrics::Instance().BytesWritten( total );
+   return( total );
+#else
+   if( !Seek( offset ) )
+      return( 0 );
+   return( Write( buffer, buffer_size ) );
+#endif
+  }
+//+----------------------------------------------------+
+//|                              |
+//+----------------------------------------------------+
+bool CBinFile::Seek( const long long offset )
+  {
+   if( m_stream == nullptr || offset < 0 )
+      return( false );
+#ifdef _WIN32
+   return( _fseeki64( m_stream, offset, SEEK_SET ) == 0 );
+#else
+   return( fseeko( m_stream, offset, SEEK_SET ) == 0 );
+#endif
+  }
+//+----------------------------------------------------+
+//|                            |
+//+----------------------------------------------------+
+int CBinFile::Handle()
+  {
+   if( m_stream == nullptr )
+      return( -1 );
+#ifdef _WIN32
+   return( _fileno( m_stream ) );
+#else
+   return( fileno( m_stream ) );
+#endif
+  }
+//+----------------------------------------------------+
+//|  O_DIRECT                                |
+//+----------------------------------------------------+
+void CBinFile::DirectDisable()
+  {
+   if( !( m_mode & MODE_DIRECT ) )
+      return;
+   m_mode &= ~MODE_DIRECT;
+#ifdef __linux__
+//---     ,      
+   const int flags = fcntl( Handle(), F_GETFL );
+   if( flags >= 0 )
+      fcntl( Handle(), F_SETFL, flags & ~O_DIRECT );
+#endif
+  }
+//+----------------------------------------------------+
+//|  io_uring                                |
+//+----------------------------------------------------+
+bool CBinFile::UringDisable( const long long offset )
+  {
+   m_mode &= ~MODE_URING;
+   DirectDisable();
+//---  io_uring   ,     
+   return( Seek( offset ) );
+  }
+//+----------------------------------------------------+
+//|                    |
+//+----------------------------------------------------+
+bool CBinFile::Map( const long long offset, const size_t length, const char* &data )
+  {
+   Unmap();
+   if( m_stream == nullptr || offset < 0 || length == 0 )
+      return( false );
+#ifdef _WIN32
+   return( false );
+#else
+//---      
+   const long long page_size = sysconf( _SC_PAGE_SIZE );
+   const long long map_offset = page_size > 0 ? offset / page_size * page_size : offset;
+   m_map_size = length + size_t( offset - map_offset );
+   int flags = MAP_PRIVATE;
+#ifdef MAP_POPULATE
+//---   ,   page fault  
+   flags |= MAP_POPULATE;
+#endif
+   m_map = mmap( nullptr, m_map_size, PROT_READ, flags, Handle(), (off_t) map_offset );
+   if( m_map == MAP_FAILED )
+     {
+      m_map = nullptr;
+      m_map_size = 0;
+      return( false );
+     }
+   madvise( m_map, m_map_size, MADV_SEQUENTIAL );
+   data = (const char*) m_map + ( offset - map_offset );
+//---    
+   CMetrics::Instance().BytesRead( length );
+   return( true );
+#endif
+  }
+//+----------------------------------------------------+
+//|                                   |
+//+----------------------------------------------------+
+void CBinFile::Unmap()
+  {
+#ifndef _WIN32
+   if( m_map != nullptr )
+      munmap( m_map, m_map_size );
+#endif
+   m_map = nullptr;
+   m_map_size = 0;
   }
 //+----------------------------------------------------+
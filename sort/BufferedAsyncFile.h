@@ -12,28 +12,39 @@ private:
    //---  
    boost::asio::io_service &m_io_service;
    //--- 
-   std::unique_ptr<char[]> m_buffer;
+   CMemoryBudget::Buffer m_buffer;
    const size_t      m_buffer_size;
    //---    
    size_t            m_data_size;
+   //---    
+   size_t            m_read_remaining;
+   //---  io_uring:          
+   CUring            m_uring;
+   long long         m_offset;
+   size_t            m_uring_size;
+   size_t            m_request_size;
+   size_t            m_requests;
+   std::vector<int>  m_results;
+   //---  :        -
+   bool              m_uring_failed;
    //---   IO
    bool              m_completed;
    boost::mutex      m_completed_sync;
    boost::condition_variable m_completed_cond;
 
 public:
-                     CBufferedAsyncFile( boost::asio::io_service &io, const size_t buffer_size );
+                     CBufferedAsyncFile( boost::asio::io_service &io, CMemoryBudget &memory, const size_t buffer_size );
                     ~CBufferedAsyncFile();
    //--- 
    std::string       Name() { return( m_file.Name() ); }
    int               Mode() { return( m_file.Mode() ); }
    //--- / 
-   bool              Open( const std::string &file_name, const int mode );
+   bool              Open( const std::string &file_name, const int mode, const size_t offset = 0, const size_t length = std::numeric_limits<size_t>::max() );
    void              Close();
    //---  
-   size_t            Read( std::unique_ptr<char[]> &buffer );
+   size_t            Read( CMemoryBudget::Buffer &buffer );
    //---  
-   void              Write( std::unique_ptr<char[]> &buffer, size_t data_size );
+   void              Write( CMemoryBudget::Buffer &buffer, size_t data_size );
 
 private:
    //--- /   
@@ -45,11 +56,14 @@ private:
    //---  
    void              WriteAsync();
    void              WriteAsyncHandler();
+   //---    io_uring    
+   void              UringSubmit( const bool write );
+   void              UringComplete( const bool write );
   };
 //+----------------------------------------------------+
 //|                                         |
 //+----------------------------------------------------+
-CBufferedAsyncFile::CBufferedAsyncFile( boost::asio::io_service &io, const size_t buffer_size ) : m_io_service( io ), m_buffer( new char[buffer_size] ), m_buffer_size( buffer_size ), m_data_size( 0 ), m_completed( true )
+CBufferedAsyncFile::CBufferedAsyncFile( boost::asio::io_service &io, CMemoryBudget &memory, const size_t buffer_size ) : m_io_service( io ), m_buffer( memory.Allocate( buffer_size ) ), m_buffer_size( buffer_size ), m_data_size( 0 ), m_read_remaining( 0 ), m_offset( 0 ), m_uring_size( 0 ), m_request_size( 0 ), m_requests( 0 ), m_results( URING_DEPTH, 0 ), m_uring_failed( false ), m_completed( true )
   {
   }
 //+----------------------------------------------------+
@@ -62,12 +76,25 @@ CBufferedAsyncFile::~CBufferedAsyncFile()
 //+----------------------------------------------------+
 //|                                       |
 //+----------------------------------------------------+
-bool CBufferedAsyncFile::Open( const std::string &file_name, const int mode )
+bool CBufferedAsyncFile::Open( const std::string &file_name, const int mode, const size_t offset, const size_t length )
   {
    Close();
+//--- io_uring  O_DIRECT     ,   -   
+   int file_mode = mode;
+   m_uring_failed = false;
+   if( !( mode & CBinFile::MODE_URING ) || ( !m_uring.Ready() && !m_uring.Init( URING_DEPTH ) ) )
+      file_mode &= ~( CBinFile::MODE_URING | CBinFile::MODE_DIRECT );
 //---  
-   if( !m_file.Open( file_name, mode ) )
+   if( !m_file.Open( file_name, file_mode ) )
       return( false );
+//---     [offset, offset + length)
+   m_offset = offset;
+   if( !( file_mode & CBinFile::MODE_URING ) && offset > 0 && !m_file.Seek( offset ) )
+     {
+      m_file.Close();
+      return( false );
+     }
+   m_read_remaining = length;
 //---       
    if( mode & CBinFile::MODE_READ )
       ReadAsync();
@@ -86,7 +113,7 @@ void CBufferedAsyncFile::Close()
 //+----------------------------------------------------+
 //|                                        |
 //+----------------------------------------------------+
-size_t CBufferedAsyncFile::Read( std::unique_ptr<char[]> &buffer )
+size_t CBufferedAsyncFile::Read( CMemoryBudget::Buffer &buffer )
   {
 //---    
    AsyncWait();
@@ -101,7 +128,7 @@ size_t CBufferedAsyncFile::Read( std::unique_ptr<char[]> &buffer )
 //+----------------------------------------------------+
 //|                                        |
 //+----------------------------------------------------+
-void CBufferedAsyncFile::Write( std::unique_ptr<char[]> &buffer, size_t data_size )
+void CBufferedAsyncFile::Write( CMemoryBudget::Buffer &buffer, size_t data_size )
   {
 //---    
    AsyncWait();
@@ -129,10 +156,22 @@ void CBufferedAsyncFile::AsyncWait()
 //---    
    if( m_completed )
       return;
-   boost::unique_lock<boost::mutex> lock( m_completed_sync );
-//--- TODO:   
-   if( !m_completed )
-      m_completed_cond.wait( lock );
+   CTraceScope trace( "async wait" );
+   const unsigned long long start = CMetrics::Now();
+//---  io_uring    
+   if( m_file.Mode() & CBinFile::MODE_URING )
+     {
+      UringComplete( ( m_file.Mode() & CBinFile::MODE_WRITE ) != 0 );
+      m_completed = true;
+     }
+   else
+     {
+      boost::unique_lock<boost::mutex> lock( m_completed_sync );
+      //--- TODO:   
+      if( !m_completed )
+         m_completed_cond.wait( lock );
+     }
+   CMetrics::Instance().AsyncWait( CMetrics::Now() - start );
   }
 //+----------------------------------------------------+
 //|                                   |
@@ -141,15 +180,20 @@ void CBufferedAsyncFile::ReadAsync()
   {
    m_completed = false;
    m_data_size = 0;
-   m_io_service.post( boost::bind( &CBufferedAsyncFile::ReadAsyncHandler, this ) );
+   if( m_file.Mode() & CBinFile::MODE_URING )
+      UringSubmit( false );
+   else
+      m_io_service.post( boost::bind( &CBufferedAsyncFile::ReadAsyncHandler, this ) );
   }
 //+----------------------------------------------------+
 //|                        |
 //+----------------------------------------------------+
 void CBufferedAsyncFile::ReadAsyncHandler()
   {
-//---     
-   m_data_size = m_file.Read( m_buffer.get(), m_buffer_size );
+   CTraceScope trace( "read" );
+//---     ,     
+   m_data_size = m_file.Read( m_buffer.get(), std::min( m_buffer_size, m_read_remaining ) );
+   m_read_remaining -= m_data_size;
 //---    
    AsyncComplete();
   }
@@ -159,16 +203,120 @@ void CBufferedAsyncFile::ReadAsyncHandler()
 void CBufferedAsyncFile::WriteAsync()
   {
    m_completed = false;
-   m_io_service.post( boost::bind( &CBufferedAsyncFile::WriteAsyncHandler, this ) );
+   if( m_file.Mode() & CBinFile::MODE_URING )
+      UringSubmit( true );
+   else
+      m_io_service.post( boost::bind( &CBufferedAsyncFile::WriteAsyncHandler, this ) );
   }
 //+----------------------------------------------------+
 //|                         |
 //+----------------------------------------------------+
 void CBufferedAsyncFile::WriteAsyncHandler()
   {
+   CTraceScope trace( "write" );
 //---     
    m_file.Write( m_buffer.get(), m_data_size );
 //---    
    AsyncComplete();
   }
 //+----------------------------------------------------+
+//|    io_uring                     |
+//+----------------------------------------------------+
+void CBufferedAsyncFile::UringSubmit( const bool write )
+  {
+   const size_t alignment = CMemoryBudget::ALIGNMENT;
+   size_t size = write ? m_data_size : std::min( m_buffer_size, m_read_remaining );
+//--- O_DIRECT     ,     ,
+//---   (   )     
+   if( m_file.Mode() & CBinFile::MODE_DIRECT )
+     {
+      const size_t aligned = write ? size : size / alignment * alignment;
+      if( m_offset % alignment != 0 || aligned == 0 || aligned % alignment != 0 )
+         m_file.DirectDisable();
+      else
+         size = aligned;
+     }
+//---    ,   
+   m_uring_size = size;
+   m_request_size = ( ( size + URING_DEPTH - 1 ) / URING_DEPTH + alignment - 1 ) / alignment * alignment;
+   m_requests = ( m_request_size > 0 ) ? ( size + m_request_size - 1 ) / m_request_size : 0;
+   std::fill( m_results.begin(), m_results.end(), 0 );
+//---            
+   for( size_t request = 0; request < m_requests; request++ )
+     {
+      const size_t offset = request * m_request_size;
+      const size_t request_size = std::min( m_request_size, size - offset );
+      const bool queued = write ? m_uring.Write( m_file.Handle(), m_buffer.get() + offset, request_size, m_offset + offset, request ) :
+                                  m_uring.Read( m_file.Handle(), m_buffer.get() + offset, request_size, m_offset + offset, request );
+      if( !queued )
+        {
+         m_uring_failed = true;
+         break;
+        }
+     }
+   if( m_requests > 0 && !m_uring.Submit() )
+      m_uring_failed = true;
+  }
+//+----------------------------------------------------+
+//|   io_uring                       |
+//+----------------------------------------------------+
+void CBufferedAsyncFile::UringComplete( const bool write )
+  {
+//---     :      
+   while( m_uring.Inflight() > 0 )
+     {
+      unsigned long long tag;
+      int result;
+      if( !m_uring.Complete( tag, result ) )
+         break;
+      if( tag < m_requests )
+         m_results[tag] = result;
+     }
+//---         
+   size_t done = 0;
+   for( size_t request = 0; request < m_requests; request++ )
+     {
+      const size_t offset = request * m_request_size;
+      const size_t request_size = std::min( m_request_size, m_uring_size - offset );
+      size_t completed = m_results[request] > 0 ? (size_t) m_results[request] : 0;
+      //---     
+      if( write )
+         CMetrics::Instance().BytesWritten( completed );
+      else
+         CMetrics::Instance().BytesRead( completed );
+      if( completed < request_size )
+        {
+         m_file.DirectDisable();
+         if( write )
+            completed += m_file.WriteAt( m_buffer.get() + offset + completed, request_size - completed, m_offset + offset + completed );
+         else
+            completed += m_file.ReadAt( m_buffer.get() + offset + completed, request_size - completed, m_offset + offset + completed );
+        }
+      done += completed;
+      //---     ,   -  
+      if( completed < request_size )
+         break;
+     }
+   m_requests = 0;
+   if( write )
+     {
+      if( done < m_uring_size )
+         std::cerr << "failed to write to file " << m_file.Name() << std::endl;
+      m_offset += m_uring_size;
+     }
+   else
+     {
+      m_data_size = done;
+      m_read_remaining -= done;
+      m_offset += done;
+     }
+//---     :       
+   if( m_uring_failed )
+     {
+      m_uring.Close();
+      m_uring_failed = false;
+      if( !m_file.UringDisable( m_offset ) )
+         std::cerr << "failed to seek file " << m_file.Name() << std::endl;
+     }
+  }
+//+----------------------------------------------------+
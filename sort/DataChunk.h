@@ -2,11 +2,6 @@
 //| Author: Maxim Ulyanov <ulyanov.maxim@gmail.com>    |
 //+----------------------------------------------------+
 //+----------------------------------------------------+
-//|                                  |
-//+----------------------------------------------------+
-template<class IntType = unsigned>
-class CDataChunkItem;
-//+----------------------------------------------------+
 //|                     |
 //+----------------------------------------------------+
 template<class IntType = unsigned>
@@ -18,33 +13,60 @@ public:
    typedef std::vector<Ptr> PtrArray;
 
 private:
+   typedef CRunCodec<IntType> Codec;
    //---    
    CBufferedAsyncFile m_file;
    //--- 
-   std::unique_ptr<char[]> m_data;
+   CMemoryBudget::Buffer m_data;
    //---   
    const size_t      m_data_max;
    //---   
    size_t            m_data_len;
    //---   
    size_t            m_data_current;
+   //---   :  ,     ,
+   //---          
+   bool              m_compressed;
+   std::vector<IntType> m_block;
+   size_t            m_block_current;
+   size_t            m_block_len;
+   size_t            m_skip;
+   size_t            m_left;
+   //--- ,   ,  
+   std::vector<typename Codec::RadixType> m_staging;
 
 public:
-                     CDataChunk( boost::asio::io_service &io, const size_t buffer_size );
+                     CDataChunk( boost::asio::io_service &io, CMemoryBudget &memory, const size_t buffer_size );
                     ~CDataChunk();
    //--- / 
-   bool              Open( const std::string &file_name, const int mode );
+   bool              Open( const std::string &file_name, const int mode, const size_t offset = 0, const size_t length = std::numeric_limits<size_t>::max() );
+   //---    : skip   , count  
+   bool              OpenCompressed( const std::string &file_name, const int mode, const size_t offset, const size_t length, const size_t skip, const size_t count );
    void              Close();
    //---    
-   bool              Read( CDataChunkItem<IntType> &item );
+   bool              Read( IntType &item );
+   //---        
+   bool              ReadWindow( const IntType* &begin, const IntType* &end );
+   void              ReadCommit( const IntType* position ) { if( m_compressed ) m_block_current = position - m_block.data(); else m_data_current = (const char*) position - m_data.get(); }
    //---    
-   bool              Write( CDataChunkItem<IntType> item );
+   bool              Write( const IntType &item );
+   //---     
+   bool              Write( const IntType* begin, const IntType* end );
+   //---        
+   bool              WriteWindow( IntType* &begin, IntType* &end );
+   void              WriteCommit( IntType* position ) { m_data_len = (char*) position - m_data.get(); }
+
+private:
+   //---     
+   bool              BlockWindow( const IntType* &begin, const IntType* &end );
+   //---    
+   bool              Fetch( const size_t size, const char* &data );
   };
 //+----------------------------------------------------+
 //|                                         |
 //+----------------------------------------------------+
 template<class IntType>
-CDataChunk<IntType>::CDataChunk( boost::asio::io_service &io, const size_t buffer_size ) : m_file( io, buffer_size ), m_data( new char[buffer_size] ), m_data_max( buffer_size ), m_data_len( 0 ), m_data_current( 0 )
+CDataChunk<IntType>::CDataChunk( boost::asio::io_service &io, CMemoryBudget &memory, const size_t buffer_size ) : m_file( io, memory, buffer_size ), m_data( memory.Allocate( buffer_size ) ), m_data_max( buffer_size ), m_data_len( 0 ), m_data_current( 0 ), m_compressed( false ), m_block_current( 0 ), m_block_len( 0 ), m_skip( 0 ), m_left( 0 )
   {
   }
 //+----------------------------------------------------+
@@ -59,11 +81,25 @@ CDataChunk<IntType>::~CDataChunk()
 //|                                       |
 //+----------------------------------------------------+
 template<class IntType>
-bool CDataChunk<IntType>::Open( const std::string &file_name, const int mode )
+bool CDataChunk<IntType>::Open( const std::string &file_name, const int mode, const size_t offset, const size_t length )
   {
    Close();
 //---  
-   m_file.Open( file_name, mode );
+   return( m_file.Open( file_name, mode, offset, length ) );
+  }
+//+----------------------------------------------------+
+//|                         |
+//+----------------------------------------------------+
+template<class IntType>
+bool CDataChunk<IntType>::OpenCompressed( const std::string &file_name, const int mode, const size_t offset, const size_t length, const size_t skip, const size_t count )
+  {
+   if( !Open( file_name, mode, offset, length ) )
+      return( false );
+   m_compressed = true;
+   m_block.resize( Codec::BLOCK_ITEMS );
+   m_staging.resize( ( sizeof( typename Codec::SHeader ) + Codec::LANES * Codec::WORD_BITS * sizeof( typename Codec::RadixType ) ) / sizeof( typename Codec::RadixType ) );
+   m_skip = skip;
+   m_left = count;
    return( true );
   }
 //+----------------------------------------------------+
@@ -80,93 +116,172 @@ void CDataChunk<IntType>::Close()
 //---  
    m_data_len = 0;
    m_data_current = 0;
+   m_compressed = false;
+   m_block_current = m_block_len = 0;
+   m_skip = m_left = 0;
   }
 //+----------------------------------------------------+
 //|                            |
 //+----------------------------------------------------+
 template<class IntType>
-bool CDataChunk<IntType>::Read( CDataChunkItem<IntType> &item )
+bool CDataChunk<IntType>::Read( IntType &item )
   {
+   const IntType *begin, *end;
+   if( !ReadWindow( begin, end ) )
+      return( false );
+//---  
+   item = *begin;
+   ReadCommit( begin + 1 );
+//--- ok
+   return( true );
+  }
+//+----------------------------------------------------+
+//|            |
+//+----------------------------------------------------+
+template<class IntType>
+bool CDataChunk<IntType>::ReadWindow( const IntType* &begin, const IntType* &end )
+  {
+   if( m_compressed )
+      return( BlockWindow( begin, end ) );
 //---      
-   if( m_data_len == 0 || m_data_current == m_data_len )
+   if( m_data_len == 0 || m_data_current >= m_data_len )
      {
-      //---     
+      //---        
       m_data_current = 0;
       m_data_len = m_file.Read( m_data );
       //---    
       if( m_data_len == 0 || m_data_len > m_data_max || m_data_len % sizeof( IntType ) != 0 )
+        {
+         m_data_len = 0;
          return( false );
+        }
      }
-//---  
-   item.m_item = *(IntType*) &m_data[m_data_current];
-   m_data_current += sizeof( IntType );
-//--- ok
+//---     
+   begin = (const IntType*) &m_data[m_data_current];
+   end = (const IntType*) &m_data[m_data_len];
    return( true );
   }
 //+----------------------------------------------------+
-//|                                 |
+//|       |
 //+----------------------------------------------------+
 template<class IntType>
-bool CDataChunk<IntType>::Write( CDataChunkItem<IntType> item )
+bool CDataChunk<IntType>::BlockWindow( const IntType* &begin, const IntType* &end )
   {
-//--- ,     
-   if( m_data_len >= m_data_max )
-      return( false );
-//---  
-   *(IntType*) &m_data[m_data_len] = item.m_item;
-   m_data_len += sizeof( IntType );
-//---   
-   if( m_data_len >= m_data_max )
+   while( m_block_current >= m_block_len )
      {
-      //---  
-      m_file.Write( m_data, m_data_len );
-      m_data_len = 0;
+      if( m_left == 0 )
+         return( false );
+      //---      
+      typename Codec::SHeader header;
+      const char* data = nullptr;
+      if( !Fetch( sizeof( header ), data ) )
+         return( false );
+      memcpy( &header, data, sizeof( header ) );
+      if( !Codec::Valid( header ) || !Fetch( Codec::BodySize( header ), data ) )
+        {
+         m_left = 0;
+         return( false );
+        }
+      Codec::Decode( header, data, m_block.data() );
+      //---         
+      m_block_current = std::min<size_t>( m_skip, header.count );
+      m_skip -= m_block_current;
+      m_block_len = std::min<size_t>( header.count, m_block_current + m_left );
+      m_left -= m_block_len - m_block_current;
      }
-//--- ok
+   begin = m_block.data() + m_block_current;
+   end = m_block.data() + m_block_len;
    return( true );
   }
 //+----------------------------------------------------+
-//|                                        |
+//|                     |
 //+----------------------------------------------------+
 template<class IntType>
-class CDataChunkItem
+bool CDataChunk<IntType>::Fetch( const size_t size, const char* &data )
   {
-   friend class CDataChunk<IntType>;
-
-private:
-   IntType           m_item;
-   std::weak_ptr<CDataChunk<IntType>> m_chunk;
-
-public:
-                     CDataChunkItem( std::shared_ptr<CDataChunk<IntType>> chunk );
-   bool              operator>( const CDataChunkItem<IntType> &chunk_item ) const;
-   //---  
-   bool              Next();
-  };
+//---     
+   if( m_data_len - m_data_current >= size )
+     {
+      data = &m_data[m_data_current];
+      m_data_current += size;
+      return( true );
+     }
+//---          
+   char* staging = (char*) m_staging.data();
+   size_t filled = 0;
+   while( filled < size )
+     {
+      if( m_data_current >= m_data_len )
+        {
+         m_data_current = 0;
+         m_data_len = m_file.Read( m_data );
+         if( m_data_len == 0 || m_data_len > m_data_max )
+           {
+            m_data_len = 0;
+            return( false );
+           }
+        }
+      const size_t count = std::min( size - filled, m_data_len - m_data_current );
+      memcpy( staging + filled, &m_data[m_data_current], count );
+      m_data_current += count;
+      filled += count;
+     }
+   data = staging;
+   return( true );
+  }
 //+----------------------------------------------------+
-//|                                         |
+//|                                 |
 //+----------------------------------------------------+
 template<class IntType>
-CDataChunkItem<IntType>::CDataChunkItem( std::shared_ptr<CDataChunk<IntType>> chunk ) : m_item( 0 ), m_chunk( chunk )
+bool CDataChunk<IntType>::Write( const IntType &item )
   {
+   IntType *begin, *end;
+   if( !WriteWindow( begin, end ) )
+      return( false );
+//---  
+   *begin = item;
+   m_data_len += sizeof( IntType );
+//--- ok
+   return( true );
   }
 //+----------------------------------------------------+
-//|                                      |
+//|                       |
 //+----------------------------------------------------+
 template<class IntType>
-bool CDataChunkItem<IntType>::operator> ( const CDataChunkItem<IntType> &chunk_item ) const
+bool CDataChunk<IntType>::Write( const IntType* begin, const IntType* end )
   {
-   return( this->m_item > chunk_item.m_item );
+   while( begin < end )
+     {
+      IntType *window_begin, *window_end;
+      if( !WriteWindow( window_begin, window_end ) )
+         return( false );
+      //---  ,    
+      const size_t count = std::min<size_t>( end - begin, window_end - window_begin );
+      memcpy( window_begin, begin, count * sizeof( IntType ) );
+      WriteCommit( window_begin + count );
+      begin += count;
+     }
+//--- ok
+   return( true );
   }
 //+----------------------------------------------------+
-//|                                   |
+//|                   |
 //+----------------------------------------------------+
 template<class IntType>
-bool CDataChunkItem<IntType>::Next()
+bool CDataChunk<IntType>::WriteWindow( IntType* &begin, IntType* &end )
   {
-   if( m_chunk.expired() )
+   const size_t data_max = m_data_max / sizeof( IntType ) * sizeof( IntType );
+//---   ,       
+   if( m_data_len >= data_max && m_data_len > 0 )
+     {
+      m_file.Write( m_data, m_data_len );
+      m_data_len = 0;
+     }
+//--- ,     
+   if( m_data_len >= data_max )
       return( false );
-   std::shared_ptr<CDataChunk<IntType>> chunk( m_chunk.lock() );
-   return( chunk->Read( *this ) );
+   begin = (IntType*) &m_data[m_data_len];
+   end = (IntType*) &m_data[data_max];
+   return( true );
   }
 //+----------------------------------------------------+
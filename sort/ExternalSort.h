@@ -2,36 +2,172 @@
 //| Author: Maxim Ulyanov <ulyanov.maxim@gmail.com>    |
 //+----------------------------------------------------+
 //+----------------------------------------------------+
+//|             |
+//+----------------------------------------------------+
+enum EnRunGeneration
+  {
+   RUNS_SORT = 0,
+   RUNS_REPLACEMENT
+  };
+//+----------------------------------------------------+
+//|                                 |
+//+----------------------------------------------------+
+enum EnReduce
+  {
+   REDUCE_NONE = 0,
+   //---     
+   REDUCE_UNIQUE,
+   //---    64-   
+   REDUCE_COUNT
+  };
+//+----------------------------------------------------+
 //|                                   |
 //+----------------------------------------------------+
 template<class IntType = unsigned, class ParallelSort = CParallelQuickSort<IntType>>
 class CExternalSort
   {
 private:
+   //---    :      ,    
+   static const size_t COUNT_ITEMS = 1 + ( sizeof( unsigned long long ) + sizeof( IntType ) - 1 ) / sizeof( IntType );
+   //---    
+   CMemoryBudget    &m_memory;
    //---   
    const size_t      m_buffer_size;
-   //---  
+   //---  -:    
    boost::asio::io_service &m_io_service;
+   //---  :     
+   boost::asio::io_service &m_cpu_service;
    //---  
    ParallelSort      m_parallel_sort;
+   //---   
+   const EnRunGeneration m_run_generation;
+   //---  -     
+   const int         m_io_mode;
+   //---  ,   
+   const bool        m_compress_runs;
    //---    
    std::vector<std::string> m_chunks;
+   //---       
+   std::string       m_chunk_base;
+   size_t            m_chunks_created;
+   //---   ,   -     
+   const std::vector<std::string> m_tmp_dirs;
+   //---   
+   const EnReduce    m_reduce;
+   //---    (  ) ,  size_t - 
+   const size_t      m_limit;
+   //---     :      ,   ,
+   //---  
+   std::vector<CMemoryBudget::Buffer> m_select_buffers;
+   std::vector<CMemoryBudget::Buffer> m_select_blocks;
+   std::vector<size_t> m_select_counts;
+   size_t            m_selects_done;
+   bool              m_select_failed;
+   boost::mutex      m_select_sync;
+   boost::condition_variable m_select_cond;
+   //---  :  ,      ,  ,
+   //---         ;     
+   CBinFile          m_split_input;
+   long long         m_split_input_size;
+   long long         m_split_offset;
+   size_t            m_split_buffer_size;
+   bool              m_split_spare;
+   std::vector<CMemoryBudget::Buffer> m_split_buffers;
+   std::vector<size_t> m_split_free;
+   std::deque<std::pair<size_t, size_t>> m_split_read;
+   //---   ,  ,    ,    
+   bool              m_split_reading;
+   bool              m_split_read_done;
+   size_t            m_split_writing;
+   bool              m_split_failed;
+   boost::mutex      m_split_sync;
+   boost::condition_variable m_split_cond;
+   //---    
+   const size_t      m_merge_concurrency;
+   //---   
+   size_t            m_partitions_merged;
+   bool              m_partitions_failed;
+   //--- ,          ;   
+   //---      
+   EnReduce          m_partitions_reduce;
+   std::vector<size_t> m_partitions_limit;
+   std::vector<size_t> m_partitions_written;
+   boost::mutex      m_partitions_sync;
+   boost::condition_variable m_partitions_cond;
 
 public:
    //--- /
-                     CExternalSort( boost::asio::io_service &io, const int concurrency_level ) : m_buffer_size( RAM_MAX / 4 ), m_io_service( io ), m_parallel_sort( io, concurrency_level ) {};
+                     CExternalSort( boost::asio::io_service &io, boost::asio::io_service &cpu, CMemoryBudget &memory, const int concurrency_level, const EnRunGeneration run_generation = RUNS_SORT, const int io_mode = CBinFile::MODE_NONE, const bool compress_runs = false, const std::vector<std::string> &tmp_dirs = std::vector<std::string>(), const EnReduce reduce = REDUCE_NONE, const size_t limit = std::numeric_limits<size_t>::max() ) : m_memory( memory ), m_buffer_size( BufferSize( memory.Limit() / 4 ) ), m_io_service( io ), m_cpu_service( cpu ), m_parallel_sort( cpu, concurrency_level ), m_run_generation( run_generation ), m_io_mode( io_mode ), m_compress_runs( compress_runs && CRunCodec<IntType>::SUPPORTED ), m_chunks_created( 0 ), m_tmp_dirs( tmp_dirs ), m_reduce( reduce ), m_limit( limit ), m_selects_done( 0 ), m_select_failed( false ), m_split_input_size( 0 ), m_split_offset( 0 ), m_split_buffer_size( 0 ), m_split_spare( true ), m_split_reading( false ), m_split_read_done( false ), m_split_writing( 0 ), m_split_failed( false ), m_merge_concurrency( std::max( 1, concurrency_level / CONCURRENCY_MULTIPLIER ) ), m_partitions_merged( 0 ), m_partitions_failed( false ), m_partitions_reduce( REDUCE_NONE ) {};
    //---   <input_file_name>,    <output_file_name>
    void              Sort( std::string input_file_name, std::string output_file_name );
 
 private:
+   //---    
+   void              SortFile( std::string &input_file_name, std::string &output_file_name );
+   //---  :   ,  ,   O_DIRECT
+   static size_t     BufferSize( const size_t size );
    //---      
-   std::string       ChunkNextName( const std::string &input_file_name );
+   std::string       ChunkNextName();
+   //---    
+   std::string       ChunkNextDir();
    //---  
    void              ChunkAdd( const std::string &chunk_name );
-   //---      
+   //---     output    ; false -   
+   bool              ChunkCompress( const std::string &chunk_name, const IntType* begin, const IntType* end, char* output, const size_t output_max, size_t &output_size );
+   //---     ,    
+   static IntType*   Unique( IntType* begin, IntType* end );
+   //---      COUNT_ITEMS 
+   static void       CountItem( const IntType &key, const unsigned long long count, IntType* item );
+   //---       
+   static bool       CountWrite( CBinFile &file, const IntType* begin, const IntType* end, const size_t limit );
+   //---     ,   
+   bool              SortInMemory( std::string &input_file_name, std::string &output_file_name, const size_t data_size );
+   //---  ,    m_limit 
+   size_t            LimitSize( const size_t size ) const { return( size / sizeof( IntType ) > m_limit ? m_limit * sizeof( IntType ) : size ); }
+   //---        , 0 -         
+   size_t            SelectWorkers( const size_t data_size ) const;
+   //---             
+   bool              Select( std::string &input_file_name, std::string &output_file_name, const size_t data_size, const size_t workers );
+   //---       [begin, end)
+   void              SelectRange( const std::string input_file_name, const size_t worker, const size_t begin, const size_t end );
+   //---     m_limit,   
+   size_t            SelectCompact( IntType* items, const size_t count ) const;
+   //---       :   ,  
+   //---          
    bool              Split( std::string &input_file_name );
-   //---      
+   //---    ,   m_split_sync
+   void              SplitReadStart();
+   //---  :     
+   void              SplitRead( const size_t buffer );
+   void              SplitWrite( const std::string chunk_name, const size_t buffer, const size_t data_size );
+   //---      ,        
+   bool              SplitMapped( std::string &input_file_name );
+   //---       ,      
+   bool              SplitReplacement( std::string &input_file_name );
+   //---          
+   static void       HeapBuild( IntType* heap, const size_t heap_size );
+   static void       HeapSiftDown( IntType* heap, const size_t heap_size, const size_t node );
+   //---      ,     
    bool              Merge( std::string &output_file_name );
+   //---  ,      ,        MERGE_RUN_BUFFER
+   size_t            MergeFanIn( const size_t chunks_count ) const;
+   //---        
+   bool              MergeChunks( const std::vector<std::string> &chunks, const std::string &output_file_name, const EnReduce reduce, const size_t limit );
+   //---  ,   ,         limit  ()
+   bool              MergeCompact( const std::string &file_name, const std::vector<std::vector<size_t>> &bounds, const size_t items, const size_t limit );
+   //---   ,  ,     
+   static const IntType* GallopUpperBound( const IntType* begin, const IntType* end, const IntType &key );
+   //---    ,   
+   bool              ChunkLowerBound( CRunFile<IntType> &chunk, const IntType &key, size_t &position );
+   //---        
+   bool              MergeSplit( const std::vector<std::string> &chunks, const std::vector<size_t> &counts, const size_t partitions_count, std::vector<std::vector<size_t>> &bounds );
+   //---   [begin, end)    
+   bool              MergeRange( const std::vector<std::string> &chunks, const std::string &output_file_name, const std::vector<size_t> &begin, const std::vector<size_t> &end, const size_t read_buffer_size, const size_t write_buffer_size, const EnReduce reduce, const size_t limit, size_t &written );
+   //---       
+   static bool       MergeEmit( CDataChunk<IntType> &output_file, IntType* &output, IntType* &output_end, const IntType &key, const unsigned long long count, const EnReduce reduce, size_t &written );
+   //---        
+   void              MergePartition( const std::vector<std::string> chunks, const std::string output_file_name, const std::vector<size_t> begin, const std::vector<size_t> end, const size_t read_buffer_size, const size_t write_buffer_size, const size_t partition );
+   void              MergePartitionComplete( const bool success );
   };
 //+----------------------------------------------------+
 //|                                          |
@@ -39,31 +175,101 @@ private:
 template<class IntType, class ParallelSort>
 void CExternalSort<IntType, ParallelSort>::Sort( std::string input_file_name, std::string output_file_name )
   {
+//---     ,     
+   try
+     {
+      SortFile( input_file_name, output_file_name );
+     }
+   catch( std::exception &ex )
+     {
+      std::cerr << "sorting failed: " << ex.what() << std::endl;
+     }
+  }
+//+----------------------------------------------------+
+//|                    |
+//+----------------------------------------------------+
+template<class IntType, class ParallelSort>
+void CExternalSort<IntType, ParallelSort>::SortFile( std::string &input_file_name, std::string &output_file_name )
+  {
+//---         ,   ;      
+   boost::system::error_code error;
+   const size_t data_size = (size_t) boost::filesystem::file_size( input_file_name, error );
+//---           ,     
+   const size_t select_workers = error ? 0 : SelectWorkers( data_size );
+   if( select_workers > 0 )
+     {
+      Select( input_file_name, output_file_name, data_size, select_workers );
+      return;
+     }
+   if( !error && data_size <= ( m_parallel_sort.InPlace() ? m_memory.Limit() : m_memory.Limit() / 2 ) )
+     {
+      SortInMemory( input_file_name, output_file_name, data_size );
+      return;
+     }
 //---      
-   if( !Split( input_file_name ) )
+   bool split = false;
+   if( m_run_generation == RUNS_REPLACEMENT )
+      split = SplitReplacement( input_file_name );
+   else
+      split = ( m_io_mode & CBinFile::MODE_MMAP ) ? SplitMapped( input_file_name ) : Split( input_file_name );
+   if( !split )
       return;
 //---     
    Merge( output_file_name );
   }
 //+----------------------------------------------------+
+//|                                        |
+//+----------------------------------------------------+
+template<class IntType, class ParallelSort>
+size_t CExternalSort<IntType, ParallelSort>::BufferSize( const size_t size )
+  {
+   const size_t alignment = CMemoryBudget::ALIGNMENT;
+   if( alignment % sizeof( IntType ) == 0 && size >= alignment )
+      return( size / alignment * alignment );
+   return( size / sizeof( IntType ) * sizeof( IntType ) );
+  }
+//+----------------------------------------------------+
 //|            |
 //+----------------------------------------------------+
 template<class IntType, class ParallelSort>
-std::string CExternalSort<IntType, ParallelSort>::ChunkNextName( const std::string &input_file_name )
+std::string CExternalSort<IntType, ParallelSort>::ChunkNextName()
   {
 //---       ,   
-   std::string chunk_name( input_file_name );
+   std::string chunk_name( m_chunk_base );
+   if( !m_tmp_dirs.empty() )
+      chunk_name = ( boost::filesystem::path( ChunkNextDir() ) / boost::filesystem::path( m_chunk_base ).filename() ).string();
    chunk_name.append( "_" );
 //---   
    std::ostringstream chunk_index;
    chunk_index.width( 3 );
    chunk_index.fill( '0' );
-   chunk_index << m_chunks.size();
+   chunk_index << m_chunks_created++;
 //---  
    chunk_name.append( chunk_index.str() );
+//--- ,    ,       
+   remove( CRunFile<IntType>::IndexName( chunk_name ).c_str() );
    return( chunk_name );
   }
 //+----------------------------------------------------+
+//|                           |
+//+----------------------------------------------------+
+template<class IntType, class ParallelSort>
+std::string CExternalSort<IntType, ParallelSort>::ChunkNextDir()
+  {
+//---  ,    -      -    ;
+//--- ,           , 
+   const size_t first = m_chunks_created % m_tmp_dirs.size();
+   for( size_t index = 0; index < m_tmp_dirs.size(); index++ )
+     {
+      const std::string &dir = m_tmp_dirs[( first + index ) % m_tmp_dirs.size()];
+      boost::system::error_code error;
+      const boost::filesystem::space_info space = boost::filesystem::space( dir, error );
+      if( !error && space.available >= m_memory.Limit() )
+         return( dir );
+     }
+   return( m_tmp_dirs[first] );
+  }
+//+----------------------------------------------------+
 //|                                     |
 //+----------------------------------------------------+
 template<class IntType, class ParallelSort>
@@ -72,99 +278,1204 @@ void CExternalSort<IntType, ParallelSort>::ChunkAdd( const std::string &chunk_na
    m_chunks.push_back( chunk_name );
   }
 //+----------------------------------------------------+
+//|                        |
+//+----------------------------------------------------+
+template<class IntType, class ParallelSort>
+bool CExternalSort<IntType, ParallelSort>::ChunkCompress( const std::string &chunk_name, const IntType* begin, const IntType* end, char* output, const size_t output_max, size_t &output_size )
+  {
+   if( !m_compress_runs )
+      return( false );
+   std::vector<unsigned long long> offsets;
+   if( !CRunCodec<IntType>::Encode( begin, end, output, output_max, output_size, offsets ) )
+      return( false );
+   return( CRunFile<IntType>::IndexWrite( chunk_name, end - begin, offsets ) );
+  }
+//+----------------------------------------------------+
+//|                              |
+//+----------------------------------------------------+
+template<class IntType, class ParallelSort>
+IntType* CExternalSort<IntType, ParallelSort>::Unique( IntType* begin, IntType* end )
+  {
+   if( begin == end )
+      return( end );
+//---  :    ,    
+   IntType* last = begin;
+   for( IntType* item = begin + 1; item < end; item++ )
+      if( *last < *item )
+         *++last = *item;
+   return( last + 1 );
+  }
+//+----------------------------------------------------+
+//|                               |
+//+----------------------------------------------------+
+template<class IntType, class ParallelSort>
+void CExternalSort<IntType, ParallelSort>::CountItem( const IntType &key, const unsigned long long count, IntType* item )
+  {
+   item[0] = key;
+   memset( (void*) ( item + 1 ), 0, ( COUNT_ITEMS - 1 ) * sizeof( IntType ) );
+   memcpy( (void*) ( item + 1 ), &count, sizeof( count ) );
+  }
+//+----------------------------------------------------+
+//|                          |
+//+----------------------------------------------------+
+template<class IntType, class ParallelSort>
+bool CExternalSort<IntType, ParallelSort>::CountWrite( CBinFile &file, const IntType* begin, const IntType* end, const size_t limit )
+  {
+//---     4096
+   const size_t batch = 4096 * COUNT_ITEMS;
+   std::vector<IntType> items( batch );
+   size_t filled = 0, left = limit;
+   for( const IntType* item = begin; item < end && left > 0; left-- )
+     {
+      const IntType* next = item + 1;
+      while( next < end && !( *item < *next ) )
+         next++;
+      CountItem( *item, next - item, &items[filled] );
+      filled += COUNT_ITEMS;
+      item = next;
+      if( filled == batch || item == end || left == 1 )
+        {
+         const size_t size = filled * sizeof( IntType );
+         if( file.Write( (const char*) items.data(), size ) != size )
+            return( false );
+         filled = 0;
+        }
+     }
+   return( true );
+  }
+//+----------------------------------------------------+
+//|                       |
+//+----------------------------------------------------+
+template<class IntType, class ParallelSort>
+bool CExternalSort<IntType, ParallelSort>::SortInMemory( std::string &input_file_name, std::string &output_file_name, const size_t data_size )
+  {
+   CAutoTimer timer( "in-memory sorting" );
+   CMetricsPhase phase( CMetrics::PHASE_IN_MEMORY );
+   if( data_size % sizeof( IntType ) != 0 )
+     {
+      std::cerr << "invalid size of data" << std::endl;
+      return( false );
+     }
+//---         ,       
+   const bool in_place = m_parallel_sort.InPlace();
+   CMemoryBudget::Buffer unsorted_data( m_memory.Allocate( data_size ) );
+   CMemoryBudget::Buffer sorted_data( in_place ? nullptr : m_memory.Allocate( data_size ) );
+   char* result_data = in_place ? unsorted_data.get() : sorted_data.get();
+   CBinFile input_file;
+   if( !input_file.Open( input_file_name, CBinFile::MODE_READ ) )
+     {
+      std::cerr << "failed to open input file " << input_file_name << std::endl;
+      return( false );
+     }
+//---     ,     
+   const char* mapped_data = nullptr;
+   if( ( m_io_mode & CBinFile::MODE_MMAP ) && data_size > 0 && input_file.Map( 0, data_size, mapped_data ) )
+     {
+      if( !m_parallel_sort.Sort( (const IntType*) mapped_data, (const IntType*) ( mapped_data + data_size ), (IntType*) result_data, (IntType*) unsorted_data.get() ) )
+         return( false );
+     }
+   else
+     {
+      //---   
+      if( input_file.Read( unsorted_data.get(), data_size ) != data_size )
+        {
+         std::cerr << "failed to read input file " << input_file_name << std::endl;
+         return( false );
+        }
+      //--- 
+      if( !m_parallel_sort.Sort( (IntType*) unsorted_data.get(), (IntType*) ( unsorted_data.get() + data_size ), (IntType*) result_data ) )
+         return( false );
+     }
+   input_file.Close();
+//---      
+   CBinFile output_file;
+   if( !output_file.Open( output_file_name, CBinFile::MODE_WRITE ) )
+     {
+      std::cerr << "failed to open output file " << output_file_name << std::endl;
+      return( false );
+     }
+   const IntType* result_begin = (const IntType*) result_data;
+   const IntType* result_end = (const IntType*) ( result_data + data_size );
+   size_t result_size = data_size;
+   if( m_reduce == REDUCE_UNIQUE )
+      result_size = (char*) Unique( (IntType*) result_data, (IntType*) result_end ) - result_data;
+   result_size = LimitSize( result_size );
+   if( m_reduce == REDUCE_COUNT ? !CountWrite( output_file, result_begin, result_end, m_limit ) : output_file.Write( result_data, result_size ) != result_size )
+     {
+      std::cerr << "failed to write to output file" << std::endl;
+      return( false );
+     }
+   return( true );
+  }
+//+----------------------------------------------------+
+//|                     |
+//+----------------------------------------------------+
+template<class IntType, class ParallelSort>
+size_t CExternalSort<IntType, ParallelSort>::SelectWorkers( const size_t data_size ) const
+  {
+//---       ,   
+   if( m_limit == std::numeric_limits<size_t>::max() || m_reduce == REDUCE_COUNT || data_size / sizeof( IntType ) <= m_limit )
+      return( 0 );
+//---     2*m_limit    
+   const size_t block = BufferSize( SELECT_BLOCK );
+   if( m_memory.Limit() < block || m_limit > ( m_memory.Limit() - block ) / ( 2 * sizeof( IntType ) ) )
+      return( 0 );
+   return( std::min( m_merge_concurrency, m_memory.Limit() / ( 2 * m_limit * sizeof( IntType ) + block ) ) );
+  }
+//+----------------------------------------------------+
+//|                           |
+//+----------------------------------------------------+
+//|         |
+//| m_limit ,   .     |
+//| ,                        |
+//+----------------------------------------------------+
+template<class IntType, class ParallelSort>
+bool CExternalSort<IntType, ParallelSort>::Select( std::string &input_file_name, std::string &output_file_name, const size_t data_size, const size_t workers )
+  {
+   CAutoTimer timer( "selection of first elements" );
+   CMetricsPhase phase( CMetrics::PHASE_SELECT );
+   if( data_size % sizeof( IntType ) != 0 )
+     {
+      std::cerr << "invalid size of data" << std::endl;
+      return( false );
+     }
+//---       
+   const size_t elements = data_size / sizeof( IntType );
+   const size_t block = BufferSize( SELECT_BLOCK );
+   m_select_buffers.clear();
+   m_select_blocks.clear();
+   m_select_counts.assign( workers, 0 );
+   for( size_t worker = 0; worker < workers; worker++ )
+     {
+      m_select_buffers.push_back( m_memory.Allocate( 2 * m_limit * sizeof( IntType ) ) );
+      m_select_blocks.push_back( m_memory.Allocate( block ) );
+     }
+   m_selects_done = 0;
+   m_select_failed = false;
+   for( size_t worker = 0; worker < workers; worker++ )
+      m_cpu_service.post( boost::bind( &CExternalSort::SelectRange, this, input_file_name, worker, elements / workers * worker + std::min( worker, elements % workers ), elements / workers * ( worker + 1 ) + std::min( worker + 1, elements % workers ) ) );
+     {
+      boost::unique_lock<boost::mutex> lock( m_select_sync );
+      while( m_selects_done < workers )
+         m_select_cond.wait( lock );
+     }
+   if( m_select_failed )
+      return( false );
+//---    ,       
+   CBinFile output_file;
+   if( !output_file.Open( output_file_name, CBinFile::MODE_WRITE ) )
+     {
+      std::cerr << "failed to open output file " << output_file_name << std::endl;
+      return( false );
+     }
+   CLoserTree<IntType> data_items;
+   data_items.Init( workers );
+   std::vector<size_t> positions( workers, 0 );
+   for( size_t worker = 0; worker < workers; worker++ )
+      if( m_select_counts[worker] > 0 )
+         data_items.Set( worker, *(const IntType*) m_select_buffers[worker].get() );
+   data_items.Build();
+   IntType* output = (IntType*) m_select_blocks[0].get();
+   const size_t output_max = block / sizeof( IntType );
+   size_t filled = 0, left = m_limit;
+   IntType last = IntType();
+   while( !data_items.Empty() && left > 0 )
+     {
+      const size_t worker = data_items.TopSource();
+      const IntType* items = (const IntType*) m_select_buffers[worker].get();
+      const IntType &item = items[positions[worker]];
+      //---   ,  , 
+      if( m_reduce != REDUCE_UNIQUE || left == m_limit || last < item )
+        {
+         output[filled++] = item;
+         last = item;
+         left--;
+         if( filled == output_max || left == 0 )
+           {
+            if( output_file.Write( (const char*) output, filled * sizeof( IntType ) ) != filled * sizeof( IntType ) )
+              {
+               std::cerr << "failed to write to output file" << std::endl;
+               return( false );
+              }
+            filled = 0;
+           }
+        }
+      if( ++positions[worker] < m_select_counts[worker] )
+         data_items.Replace( items[positions[worker]] );
+      else
+         data_items.Pop();
+     }
+//---   :  
+   if( filled > 0 && output_file.Write( (const char*) output, filled * sizeof( IntType ) ) != filled * sizeof( IntType ) )
+     {
+      std::cerr << "failed to write to output file" << std::endl;
+      return( false );
+     }
+   m_select_buffers.clear();
+   m_select_blocks.clear();
+   return( true );
+  }
+//+----------------------------------------------------+
+//|               |
+//+----------------------------------------------------+
+template<class IntType, class ParallelSort>
+void CExternalSort<IntType, ParallelSort>::SelectRange( const std::string input_file_name, const size_t worker, const size_t begin, const size_t end )
+  {
+   CTraceScope trace( "select" );
+   bool success = false;
+   try
+     {
+      CBinFile input_file;
+      success = input_file.Open( input_file_name, CBinFile::MODE_READ );
+      if( !success )
+         std::cerr << "failed to open input file " << input_file_name << std::endl;
+      IntType* items = (IntType*) m_select_buffers[worker].get();
+      IntType* block = (IntType*) m_select_blocks[worker].get();
+      const size_t capacity = 2 * m_limit;
+      const size_t block_items = BufferSize( SELECT_BLOCK ) / sizeof( IntType );
+      //---    m_limit,          
+      size_t count = 0;
+      bool bounded = false;
+      IntType bound = IntType();
+      for( size_t position = begin; success && position < end; )
+        {
+         const size_t size = std::min( block_items, end - position ) * sizeof( IntType );
+         if( input_file.ReadAt( (char*) block, size, (long long) position * sizeof( IntType ) ) != size )
+           {
+            std::cerr << "failed to read input file " << input_file_name << std::endl;
+            success = false;
+            break;
+           }
+         position += size / sizeof( IntType );
+         for( const IntType* item = block; item < block + size / sizeof( IntType ); item++ )
+           {
+            if( bounded && !( *item < bound ) )
+               continue;
+            items[count++] = *item;
+            //---  :   m_limit,  
+            if( count == capacity )
+              {
+               count = SelectCompact( items, count );
+               bounded = ( count == m_limit );
+               if( bounded )
+                  bound = items[count - 1];
+              }
+           }
+        }
+      //---    
+      count = SelectCompact( items, count );
+      if( m_reduce != REDUCE_UNIQUE )
+         SLeafSort<IntType>::Sort( items, items + count );
+      m_select_counts[worker] = success ? count : 0;
+     }
+   catch( std::exception &ex )
+     {
+      std::cerr << "selection failed: " << ex.what() << std::endl;
+     }
+   m_select_sync.lock();
+   m_selects_done++;
+   if( !success )
+      m_select_failed = true;
+   m_select_sync.unlock();
+   m_select_cond.notify_all();
+  }
+//+----------------------------------------------------+
+//|     m_limit                |
+//+----------------------------------------------------+
+template<class IntType, class ParallelSort>
+size_t CExternalSort<IntType, ParallelSort>::SelectCompact( IntType* items, const size_t count ) const
+  {
+//---     ,  
+   if( m_reduce == REDUCE_UNIQUE )
+     {
+      SLeafSort<IntType>::Sort( items, items + count );
+      return( std::min<size_t>( Unique( items, items + count ) - items, m_limit ) );
+     }
+//---    m_limit    m_limit-1,  -  
+   if( count <= m_limit )
+      return( count );
+   std::nth_element( items, items + m_limit - 1, items + count );
+   return( m_limit );
+  }
+//+----------------------------------------------------+
 //|         |
 //+----------------------------------------------------+
 template<class IntType, class ParallelSort>
 bool CExternalSort<IntType, ParallelSort>::Split( std::string &input_file_name )
   {
    CAutoTimer timer( "input file splitting to sorted chunks" );
+   CMetricsPhase phase( CMetrics::PHASE_SPLIT );
+//---       , O_DIRECT 
+   boost::system::error_code error;
+   m_split_input_size = (long long) boost::filesystem::file_size( input_file_name, error );
+   if( error || !m_split_input.Open( input_file_name, CBinFile::MODE_READ | ( m_io_mode & CBinFile::MODE_DIRECT ) ) )
+     {
+      std::cerr << "failed to open input file " << input_file_name << std::endl;
+      return( false );
+     }
+   m_chunk_base = input_file_name;
+//---      ,   -  ;
+//---          ,    ,    
+   const bool in_place = m_parallel_sort.InPlace();
+   const size_t buffers = in_place ? SPLIT_BUFFERS / 2 : SPLIT_BUFFERS;
+   m_split_spare = !in_place || m_compress_runs;
+   m_split_buffer_size = BufferSize( m_memory.Limit() / buffers );
+   m_split_buffers.clear();
+   m_split_free.clear();
+   m_split_read.clear();
+   for( size_t buffer = 0; buffer < buffers; buffer++ )
+     {
+      m_split_buffers.push_back( m_memory.Allocate( m_split_buffer_size ) );
+      m_split_free.push_back( buffer );
+     }
+   m_split_offset = 0;
+   m_split_reading = false;
+   m_split_read_done = ( m_split_input_size == 0 );
+   m_split_writing = 0;
+   m_split_failed = false;
+//---     
+   boost::unique_lock<boost::mutex> lock( m_split_sync );
+   SplitReadStart();
+   for( ;; )
+     {
+      //---    ,        ,   
+      while( !m_split_failed && ( m_split_read.empty() ? !m_split_read_done : ( m_split_spare && m_split_free.empty() ) ) )
+         m_split_cond.wait( lock );
+      if( m_split_failed || m_split_read.empty() )
+         break;
+      const size_t source = m_split_read.front().first;
+      const size_t data_size = m_split_read.front().second;
+      m_split_read.pop_front();
+      size_t spare = source;
+      if( m_split_spare )
+        {
+         spare = m_split_free.back();
+         m_split_free.pop_back();
+        }
+      lock.unlock();
+      //--- ;         ,   
+      const size_t target = in_place ? source : spare;
+      if( !in_place )
+         spare = source;
+      char* unsorted_data = m_split_buffers[source].get();
+      char* sorted_data = m_split_buffers[target].get();
+      const bool sorted = ( data_size % sizeof( IntType ) == 0 ) && m_parallel_sort.Sort( (IntType*) unsorted_data, (IntType*) ( unsorted_data + data_size ), (IntType*) sorted_data );
+      //---      ;    ,   
+      size_t run_size = data_size;
+      if( sorted && m_reduce == REDUCE_UNIQUE )
+         run_size = (char*) Unique( (IntType*) sorted_data, (IntType*) ( sorted_data + data_size ) ) - sorted_data;
+      //---         ,     
+      if( m_reduce != REDUCE_COUNT )
+         run_size = LimitSize( run_size );
+      std::string chunk_name;
+      size_t packed_size = 0;
+      bool packed = false;
+      if( sorted )
+        {
+         chunk_name = ChunkNextName();
+         ChunkAdd( chunk_name );
+         CMetrics::Instance().RunAdded();
+         //---      
+         packed = m_split_spare && ChunkCompress( chunk_name, (const IntType*) sorted_data, (const IntType*) ( sorted_data + run_size ), m_split_buffers[spare].get(), m_split_buffer_size, packed_size );
+        }
+      lock.lock();
+      if( !sorted )
+        {
+         std::cerr << "invalid size of data" << std::endl;
+         m_split_failed = true;
+         break;
+        }
+      //--- ,    , 
+      if( spare != target )
+         m_split_free.push_back( packed ? target : spare );
+      m_split_writing++;
+      m_io_service.post( boost::bind( &CExternalSort::SplitWrite, this, chunk_name, packed ? spare : target, packed ? packed_size : run_size ) );
+      SplitReadStart();
+     }
+//---       ,  
+   while( m_split_reading || m_split_writing > 0 )
+      m_split_cond.wait( lock );
+   const bool failed = m_split_failed;
+   lock.unlock();
+   m_split_input.Close();
+   m_split_buffers.clear();
+   if( failed )
+      std::cerr << "failed to split input file " << input_file_name << std::endl;
+   return( !failed );
+  }
+//+----------------------------------------------------+
+//|                         |
+//+----------------------------------------------------+
+template<class IntType, class ParallelSort>
+void CExternalSort<IntType, ParallelSort>::SplitReadStart()
+  {
+//---     ;          
+   if( m_split_reading || m_split_read_done || m_split_failed || m_split_free.size() < ( m_split_spare ? 2u : 1u ) )
+      return;
+   const size_t buffer = m_split_free.back();
+   m_split_free.pop_back();
+   m_split_reading = true;
+   m_io_service.post( boost::bind( &CExternalSort::SplitRead, this, buffer ) );
+  }
+//+----------------------------------------------------+
+//|                                        |
+//+----------------------------------------------------+
+template<class IntType, class ParallelSort>
+void CExternalSort<IntType, ParallelSort>::SplitRead( const size_t buffer )
+  {
+   CTraceScope trace( "split read" );
+//---     ,      
+   const size_t data_size = m_split_input.ReadAt( m_split_buffers[buffer].get(), m_split_buffer_size, m_split_offset );
+   m_split_sync.lock();
+   m_split_reading = false;
+   if( data_size == 0 )
+     {
+      m_split_failed = true;
+      m_split_free.push_back( buffer );
+     }
+   else
+     {
+      m_split_offset += data_size;
+      m_split_read_done = ( m_split_offset >= m_split_input_size );
+      m_split_read.push_back( std::make_pair( buffer, data_size ) );
+      SplitReadStart();
+     }
+   m_split_sync.unlock();
+   m_split_cond.notify_all();
+  }
+//+----------------------------------------------------+
+//|                                         |
+//+----------------------------------------------------+
+template<class IntType, class ParallelSort>
+void CExternalSort<IntType, ParallelSort>::SplitWrite( const std::string chunk_name, const size_t buffer, const size_t data_size )
+  {
+   CTraceScope trace( "split write" );
+   CBinFile chunk_file;
+   bool success = chunk_file.Open( chunk_name, CBinFile::MODE_WRITE | ( m_io_mode & CBinFile::MODE_DIRECT ) );
+   if( success )
+     {
+      //--- O_DIRECT    ,       
+      if( data_size % CMemoryBudget::ALIGNMENT != 0 )
+         chunk_file.DirectDisable();
+      success = ( chunk_file.WriteAt( m_split_buffers[buffer].get(), data_size, 0 ) == data_size );
+      chunk_file.Close();
+     }
+   m_split_sync.lock();
+   m_split_writing--;
+   if( !success )
+      m_split_failed = true;
+   m_split_free.push_back( buffer );
+   SplitReadStart();
+   m_split_sync.unlock();
+   m_split_cond.notify_all();
+  }
+//+----------------------------------------------------+
+//|        |
+//+----------------------------------------------------+
+template<class IntType, class ParallelSort>
+bool CExternalSort<IntType, ParallelSort>::SplitMapped( std::string &input_file_name )
+  {
+   CAutoTimer timer( "input file splitting to sorted chunks from file mapping" );
+   CMetricsPhase phase( CMetrics::PHASE_SPLIT );
 //---  
-   CBufferedAsyncFile input_file( m_io_service, m_buffer_size );
-   if( !input_file.Open( input_file_name, CBinFile::MODE_READ ) )
+   CBinFile input_file;
+   boost::system::error_code error;
+   const long long input_size = (long long) boost::filesystem::file_size( input_file_name, error );
+   if( error || !input_file.Open( input_file_name, CBinFile::MODE_READ ) )
      {
       std::cerr << "failed to open input file " << input_file_name << std::endl;
       return( false );
      }
+//---         :       
+   const bool in_place = m_parallel_sort.InPlace() && !m_compress_runs;
+   const size_t chunk_size = in_place ? BufferSize( m_memory.Limit() / 2 ) : m_buffer_size;
+//---    ,  ;    
+   const char* mapped_data = nullptr;
+   if( input_size > 0 && !input_file.Map( 0, (size_t) std::min<long long>( chunk_size, input_size ), mapped_data ) )
+     {
+      input_file.Close();
+      return( Split( input_file_name ) );
+     }
 //---    
-   CBufferedAsyncFile chunk_file( m_io_service, m_buffer_size );
-//---      
-   std::unique_ptr<char[]> unsorted_data( new char[m_buffer_size] );
-   std::unique_ptr<char[]> sorted_data( new char[m_buffer_size] );
-//---   
-   size_t data_size = input_file.Read( unsorted_data );
-   while( data_size > 0 )
+   CBufferedAsyncFile chunk_file( m_io_service, m_memory, chunk_size );
+   m_chunk_base = input_file_name;
+//---       ;    
+   CMemoryBudget::Buffer sorted_data( m_memory.Allocate( chunk_size ) );
+   CMemoryBudget::Buffer scratch_data( in_place ? nullptr : m_memory.Allocate( chunk_size ) );
+   for( long long offset = 0; offset < input_size; offset += chunk_size )
      {
-      //---   
-      if( data_size > m_buffer_size || data_size % sizeof( IntType ) != 0 )
+      const size_t data_size = (size_t) std::min<long long>( chunk_size, input_size - offset );
+      if( data_size % sizeof( IntType ) != 0 )
         {
          std::cerr << "invalid size of data" << std::endl;
          return( false );
         }
-      //--- 
-      if( !m_parallel_sort.Sort( (IntType*) unsorted_data.get(), (IntType*) ( unsorted_data.get() + data_size ), (IntType*) sorted_data.get() ) )
+      //---   ,   
+      if( offset > 0 && !input_file.Map( offset, data_size, mapped_data ) )
+        {
+         std::cerr << "failed to map input file " << input_file_name << std::endl;
+         return( false );
+        }
+      //---        
+      if( !m_parallel_sort.Sort( (const IntType*) mapped_data, (const IntType*) ( mapped_data + data_size ), (IntType*) sorted_data.get(), (IntType*) scratch_data.get() ) )
          return( false );
+      input_file.Unmap();
+      size_t run_size = data_size;
+      if( m_reduce == REDUCE_UNIQUE )
+         run_size = (char*) Unique( (IntType*) sorted_data.get(), (IntType*) ( sorted_data.get() + data_size ) ) - sorted_data.get();
+      if( m_reduce != REDUCE_COUNT )
+         run_size = LimitSize( run_size );
       //---   
-      std::string chunk_name = ChunkNextName( input_file.Name() );
-      if( chunk_file.Open( chunk_name, CBinFile::MODE_WRITE ) )
-         ChunkAdd( chunk_name );
+      std::string chunk_name = ChunkNextName();
+      if( !chunk_file.Open( chunk_name, CBinFile::MODE_WRITE | m_io_mode ) )
+         return( false );
+      ChunkAdd( chunk_name );
+      CMetrics::Instance().RunAdded();
+      //---     ,  -    
+      size_t packed_size = 0;
+      if( !in_place && ChunkCompress( chunk_name, (const IntType*) sorted_data.get(), (const IntType*) ( sorted_data.get() + run_size ), scratch_data.get(), chunk_size, packed_size ) )
+         chunk_file.Write( scratch_data, packed_size );
       else
+         chunk_file.Write( sorted_data, run_size );
+     }
+   return( true );
+  }
+//+----------------------------------------------------+
+//|              |
+//+----------------------------------------------------+
+template<class IntType, class ParallelSort>
+bool CExternalSort<IntType, ParallelSort>::SplitReplacement( std::string &input_file_name )
+  {
+   CAutoTimer timer( "input file splitting to sorted chunks by replacement selection" );
+   CMetricsPhase phase( CMetrics::PHASE_SPLIT );
+//---           ,  - 
+   const size_t io_buffer_size = BufferSize( m_memory.Limit() / 16 );
+   CDataChunk<IntType> input_file( m_io_service, m_memory, io_buffer_size );
+   if( !input_file.Open( input_file_name, CBinFile::MODE_READ | m_io_mode ) )
+     {
+      std::cerr << "failed to open input file " << input_file_name << std::endl;
+      return( false );
+     }
+   CDataChunk<IntType> chunk_file( m_io_service, m_memory, io_buffer_size );
+   m_chunk_base = input_file_name;
+   const size_t heap_max = ( m_memory.Limit() - 4 * io_buffer_size ) / sizeof( IntType );
+   CMemoryBudget::Buffer heap_data( m_memory.Allocate( heap_max * sizeof( IntType ) ) );
+   IntType* heap = (IntType*) heap_data.get();
+//---  
+   const IntType *current = nullptr, *end = nullptr;
+   bool input_left = true;
+   size_t filled = 0;
+   while( filled < heap_max )
+     {
+      if( !input_file.ReadWindow( current, end ) )
+        {
+         input_left = false;
+         current = end;
+         break;
+        }
+      const size_t count = std::min<size_t>( end - current, heap_max - filled );
+      std::copy( current, current + count, heap + filled );
+      filled += count;
+      current += count;
+      input_file.ReadCommit( current );
+     }
+//---  - [0, heap_size),    filled - ,    
+   size_t heap_size = filled;
+   HeapBuild( heap, heap_size );
+   IntType *output = nullptr, *output_end = nullptr;
+   while( heap_size > 0 )
+     {
+      //---   -  
+      std::string chunk_name = ChunkNextName();
+      if( !chunk_file.Open( chunk_name, CBinFile::MODE_WRITE | m_io_mode ) )
+         return( false );
+      ChunkAdd( chunk_name );
+      CMetrics::Instance().RunAdded();
+      if( !chunk_file.WriteWindow( output, output_end ) )
          return( false );
-      //---     
-      chunk_file.Write( sorted_data, data_size );
-      //---   
-      data_size = input_file.Read( unsorted_data );
+      size_t run_size = 0;
+      IntType run_last = IntType();
+      while( heap_size > 0 )
+        {
+         //---    ,   -     ,  
+         //---  -      
+         const IntType top = heap[0];
+         if( ( m_reduce != REDUCE_UNIQUE || run_size == 0 || run_last < top ) && ( m_reduce == REDUCE_COUNT || run_size < m_limit ) )
+           {
+            if( output == output_end )
+              {
+               chunk_file.WriteCommit( output );
+               if( !chunk_file.WriteWindow( output, output_end ) )
+                  return( false );
+              }
+            *output++ = top;
+            run_last = top;
+            run_size++;
+           }
+         //---    ,  
+         if( current == end && input_left )
+           {
+            input_file.ReadCommit( current );
+            input_left = input_file.ReadWindow( current, end );
+            if( !input_left )
+               current = end;
+           }
+         //---      ,       
+         if( current < end )
+           {
+            const IntType item = *current++;
+            if( !( item < top ) )
+               heap[0] = item;
+            else
+              {
+               heap[0] = heap[--heap_size];
+               heap[heap_size] = item;
+              }
+           }
+         else
+           {
+            //---  :        
+            heap[0] = heap[--heap_size];
+            heap[heap_size] = heap[--filled];
+           }
+         HeapSiftDown( heap, heap_size, 0 );
+        }
+      chunk_file.WriteCommit( output );
+      chunk_file.Close();
+      //---      
+      heap_size = filled;
+      HeapBuild( heap, heap_size );
      }
    return( true );
   }
 //+----------------------------------------------------+
+//|                                      |
+//+----------------------------------------------------+
+template<class IntType, class ParallelSort>
+void CExternalSort<IntType, ParallelSort>::HeapBuild( IntType* heap, const size_t heap_size )
+  {
+   if( heap_size < 2 )
+      return;
+   for( size_t node = heap_size / 2; node > 0; node-- )
+      HeapSiftDown( heap, heap_size, node - 1 );
+  }
+//+----------------------------------------------------+
+//|                                 |
+//+----------------------------------------------------+
+template<class IntType, class ParallelSort>
+void CExternalSort<IntType, ParallelSort>::HeapSiftDown( IntType* heap, const size_t heap_size, const size_t node )
+  {
+//---        ,  ""      
+//---    ,       
+   const IntType item = heap[node];
+   size_t hole = node;
+   for( size_t child = 2 * hole + 1; child < heap_size; child = 2 * hole + 1 )
+     {
+      if( child + 1 < heap_size && heap[child + 1] < heap[child] )
+         child++;
+      heap[hole] = heap[child];
+      hole = child;
+     }
+   while( hole > node && item < heap[( hole - 1 ) / 2] )
+     {
+      heap[hole] = heap[( hole - 1 ) / 2];
+      hole = ( hole - 1 ) / 2;
+     }
+   heap[hole] = item;
+  }
+//+----------------------------------------------------+
 //|            |
 //+----------------------------------------------------+
 template<class IntType,class ParallelSort>
 bool CExternalSort<IntType, ParallelSort>::Merge(  std::string &output_file_name )
   {
    CAutoTimer timer( "merging sorted chunks to output file" );
-//---  
-   CDataChunk<IntType> output_file( m_io_service, RAM_MAX / 4 );
-   if( !output_file.Open( output_file_name, CBinFile::MODE_WRITE ) )
+//---      ,      
+   const size_t fan_in = MergeFanIn( m_chunks.size() );
+   while( m_chunks.size() > fan_in )
      {
-      std::cerr << "failed to open output file " << output_file_name << std::endl;
+      CAutoTimer pass_timer( "intermediate merge pass" );
+      CMetricsPhase phase( CMetrics::PHASE_MERGE_PASS );
+      CMetrics::Instance().MergePass();
+      std::vector<std::string> chunks;
+      chunks.swap( m_chunks );
+      //---   
+      const size_t groups_count = ( chunks.size() + fan_in - 1 ) / fan_in;
+      for( size_t group = 0; group < groups_count; group++ )
+        {
+         const std::vector<std::string> group_chunks( chunks.begin() + group * chunks.size() / groups_count, chunks.begin() + ( group + 1 ) * chunks.size() / groups_count );
+         const std::string chunk_name = ChunkNextName();
+         //---    :       
+         if( !MergeChunks( group_chunks, chunk_name, m_reduce == REDUCE_UNIQUE ? REDUCE_UNIQUE : REDUCE_NONE, m_reduce == REDUCE_COUNT ? std::numeric_limits<size_t>::max() : m_limit ) )
+            return( false );
+         ChunkAdd( chunk_name );
+        }
+     }
+//---   -   
+   CMetricsPhase phase( CMetrics::PHASE_MERGE );
+   CMetrics::Instance().MergePass();
+   return( MergeChunks( m_chunks, output_file_name, m_reduce, m_limit ) );
+  }
+//+----------------------------------------------------+
+//|                                      |
+//+----------------------------------------------------+
+template<class IntType,class ParallelSort>
+size_t CExternalSort<IntType, ParallelSort>::MergeFanIn( const size_t chunks_count ) const
+  {
+//---    MERGE_RUN_BUFFER         : 
+//---       
+   const size_t run_buffers = ( m_memory.Limit() / 4 ) / MERGE_RUN_BUFFER;
+//---      :       ,  
+//---   ;   MERGE_IO_COST  -   1/     
+   size_t fan_in_max = 2;
+   size_t passes = 0;
+   double cost_min = 0.0;
+   for( size_t partitions = 1; partitions <= m_merge_concurrency && ( partitions == 1 || run_buffers / partitions >= 2 ); partitions++ )
+     {
+      const size_t fan_in_limit = std::max<size_t>( 2, run_buffers / partitions );
+      size_t passes_count = 1;
+      for( double capacity = double( fan_in_limit ); capacity < chunks_count; capacity *= fan_in_limit )
+         passes_count++;
+      const double cost = passes_count * ( MERGE_IO_COST + 1.0 / partitions );
+      if( passes == 0 || cost < cost_min )
+        {
+         fan_in_max = fan_in_limit;
+         passes = passes_count;
+         cost_min = cost;
+        }
+     }
+//---     : ,       
+   size_t fan_in = std::max<size_t>( 2, (size_t) pow( double( chunks_count ), 1.0 / passes ) );
+   while( pow( double( fan_in ), double( passes ) ) < chunks_count )
+      fan_in++;
+   return( std::min( fan_in, fan_in_max ) );
+  }
+//+----------------------------------------------------+
+//|                          |
+//+----------------------------------------------------+
+template<class IntType,class ParallelSort>
+bool CExternalSort<IntType, ParallelSort>::MergeChunks( const std::vector<std::string> &chunks, const std::string &output_file_name, const EnReduce reduce, const size_t limit )
+  {
+//---  
+   std::vector<size_t> counts;
+   size_t total = 0;
+   for( const auto &chunk_name : chunks )
+     {
+      CRunFile<IntType> chunk;
+      if( !chunk.Open( chunk_name ) )
+        {
+         std::cerr << "invalid chunk file " << chunk_name << std::endl;
+         return( false );
+        }
+      counts.push_back( chunk.Count() );
+      total += counts.back();
+     }
+//---     ,       ;   
+//---  ,      ;      limit
+   const size_t items = ( reduce == REDUCE_COUNT ) ? COUNT_ITEMS : 1;
+   const size_t output_count = ( reduce == REDUCE_NONE ) ? std::min( total, limit ) : total;
+     {
+      CBinFile output_file;
+      if( !output_file.Open( output_file_name, CBinFile::MODE_WRITE ) )
+        {
+         std::cerr << "failed to open output file " << output_file_name << std::endl;
+         return( false );
+        }
+     }
+   boost::system::error_code error;
+   boost::filesystem::resize_file( output_file_name, output_count * items * sizeof( IntType ), error );
+   if( error )
+     {
+      std::cerr << "failed to resize output file " << output_file_name << std::endl;
+      return( false );
+     }
+//---  :    ,       MERGE_RUN_BUFFER;  
+//---      ,  ;      
+   const size_t chunks_count = std::max<size_t>( chunks.size(), 1 );
+   size_t partitions_count = std::min<size_t>( m_merge_concurrency, ( m_memory.Limit() / 4 ) / ( chunks_count * MERGE_RUN_BUFFER ) );
+   while( partitions_count > 1 && total * sizeof( IntType ) / partitions_count < MERGE_BUFFER_MIN )
+      partitions_count--;
+   partitions_count = std::max<size_t>( partitions_count, 1 );
+//---        :        
+   const size_t read_buffer_size = BufferSize( ( m_memory.Limit() / 4 ) / ( partitions_count * chunks_count ) );
+   const size_t write_buffer_size = BufferSize( ( m_memory.Limit() / 4 ) / partitions_count );
+   CMetrics::Instance().MergeStarted( chunks.size(), partitions_count, read_buffer_size );
+//---     
+   std::vector<std::vector<size_t>> bounds;
+   if( !MergeSplit( chunks, counts, partitions_count, bounds ) )
+     {
+      std::cerr << "failed to split chunks to merge partitions" << std::endl;
+      return( false );
+     }
+//---   
+   m_partitions_sync.lock();
+   m_partitions_merged = 0;
+   m_partitions_failed = false;
+   m_partitions_reduce = reduce;
+   m_partitions_limit.assign( partitions_count, limit );
+   m_partitions_written.assign( partitions_count, 0 );
+//---        :   limit  ,    
+   if( reduce == REDUCE_NONE )
+      for( size_t partition = 0; partition < partitions_count; partition++ )
+        {
+         size_t start = 0;
+         for( const auto &position : bounds[partition] )
+            start += position;
+         m_partitions_limit[partition] = start < limit ? limit - start : 0;
+        }
+   m_partitions_sync.unlock();
+   size_t partitions_posted = 0;
+   for( size_t partition = 0; partition < partitions_count; partition++ )
+      if( m_partitions_limit[partition] > 0 )
+        {
+         m_cpu_service.post( boost::bind( &CExternalSort::MergePartition, this, chunks, output_file_name, bounds[partition], bounds[partition + 1], read_buffer_size, write_buffer_size, partition ) );
+         partitions_posted++;
+        }
+   bool failed = false;
+     {
+      boost::unique_lock<boost::mutex> lock( m_partitions_sync );
+      while( m_partitions_merged < partitions_posted )
+         m_partitions_cond.wait( lock );
+      failed = m_partitions_failed;
+     }
+//---    
+   for( const auto &chunk_name : chunks )
+      CRunFile<IntType>::Remove( chunk_name );
+   if( failed )
+     {
+      std::cerr << "failed to write to output file" << std::endl;
+      return( false );
+     }
+   if( reduce != REDUCE_NONE && !MergeCompact( output_file_name, bounds, items, limit ) )
+     {
+      std::cerr << "failed to compact output file " << output_file_name << std::endl;
       return( false );
      }
+   CMetrics::Instance().ElementsMerged( total );
+   return( true );
+  }
+//+----------------------------------------------------+
+//|  ,                |
+//+----------------------------------------------------+
+template<class IntType, class ParallelSort>
+bool CExternalSort<IntType, ParallelSort>::MergeCompact( const std::string &file_name, const std::vector<std::vector<size_t>> &bounds, const size_t items, const size_t limit )
+  {
+   CBinFile file;
+   if( !file.Open( file_name, CBinFile::MODE_WRITE | CBinFile::MODE_UPDATE ) )
+      return( false );
+   CMemoryBudget::Buffer buffer( m_memory.Allocate( m_buffer_size ) );
+//---      ,    ,      ,
+//---         
+   const unsigned long long limit_size = ( limit < std::numeric_limits<size_t>::max() / ( items * sizeof( IntType ) ) ) ? (unsigned long long) limit * items * sizeof( IntType ) : std::numeric_limits<unsigned long long>::max();
+   unsigned long long target = 0;
+   for( size_t partition = 0; partition < m_partitions_written.size() && target < limit_size; partition++ )
+     {
+      unsigned long long source = 0;
+      for( const auto &position : bounds[partition] )
+         source += position;
+      source *= items * sizeof( IntType );
+      const unsigned long long length = std::min<unsigned long long>( m_partitions_written[partition] * sizeof( IntType ), limit_size - target );
+      for( unsigned long long done = 0; source != target && done < length; )
+        {
+         const size_t size = (size_t) std::min<unsigned long long>( m_buffer_size, length - done );
+         if( file.ReadAt( buffer.get(), size, source + done ) != size || file.WriteAt( buffer.get(), size, target + done ) != size )
+            return( false );
+         done += size;
+        }
+      target += length;
+     }
+   file.Close();
+   boost::system::error_code error;
+   boost::filesystem::resize_file( file_name, target, error );
+   return( !error );
+  }
+//+----------------------------------------------------+
+//|   ,              |
+//+----------------------------------------------------+
+template<class IntType, class ParallelSort>
+const IntType* CExternalSort<IntType, ParallelSort>::GallopUpperBound( const IntType* begin, const IntType* end, const IntType &key )
+  {
+//---   ,    ,      
+   size_t step = 1;
+   while( step < (size_t) ( end - begin ) && !( key < begin[step] ) )
+     {
+      begin += step;
+      step <<= 1;
+     }
+   return( std::upper_bound( begin, begin + std::min<size_t>( step, end - begin ), key ) );
+  }
+//+----------------------------------------------------+
+//|    ,     |
+//+----------------------------------------------------+
+template<class IntType, class ParallelSort>
+bool CExternalSort<IntType, ParallelSort>::ChunkLowerBound( CRunFile<IntType> &chunk, const IntType &key, size_t &position )
+  {
+//---     
+   size_t left = 0, right = chunk.Count();
+   while( left < right )
+     {
+      const size_t middle = left + ( right - left ) / 2;
+      IntType item;
+      if( !chunk.Item( middle, item ) )
+         return( false );
+      if( item < key )
+         left = middle + 1;
+      else
+         right = middle;
+     }
+   position = left;
+   return( true );
+  }
+//+----------------------------------------------------+
+//|                     |
+//+----------------------------------------------------+
+template<class IntType, class ParallelSort>
+bool CExternalSort<IntType, ParallelSort>::MergeSplit( const std::vector<std::string> &chunks, const std::vector<size_t> &counts, const size_t partitions_count, std::vector<std::vector<size_t>> &bounds )
+  {
+//---      ,    
+   bounds.assign( partitions_count + 1, std::vector<size_t>( counts.size(), 0 ) );
+   bounds[partitions_count] = counts;
+   size_t total = 0;
+   for( const auto &count : counts )
+      total += count;
+   if( partitions_count < 2 || total == 0 )
+      return( true );
+//---     
+   std::vector<std::unique_ptr<CRunFile<IntType>>> chunk_files;
+   for( const auto &chunk_name : chunks )
+     {
+      chunk_files.emplace_back( new CRunFile<IntType> );
+      if( !chunk_files.back()->Open( chunk_name ) )
+         return( false );
+     }
+//---      ,   -    
+   std::vector<std::pair<IntType, double>> samples;
+   for( size_t chunk_index = 0; chunk_index < counts.size(); chunk_index++ )
+     {
+      const size_t samples_count = std::min<size_t>( counts[chunk_index], MERGE_SAMPLES * partitions_count );
+      for( size_t sample_index = 0; sample_index < samples_count; sample_index++ )
+        {
+         IntType item;
+         if( !chunk_files[chunk_index]->Item( ( 2 * sample_index + 1 ) * counts[chunk_index] / ( 2 * samples_count ), item ) )
+            return( false );
+         samples.push_back( std::make_pair( item, double( counts[chunk_index] ) / samples_count ) );
+        }
+     }
+   std::sort( samples.begin(), samples.end() );
+//---  -  ,     -   
+   double weight = 0;
+   size_t sample_index = 0;
+   for( size_t partition = 1; partition < partitions_count; partition++ )
+     {
+      const double target = double( total ) * partition / partitions_count;
+      while( sample_index + 1 < samples.size() && weight + samples[sample_index].second < target )
+         weight += samples[sample_index++].second;
+      for( size_t chunk_index = 0; chunk_index < chunk_files.size(); chunk_index++ )
+         if( !ChunkLowerBound( *chunk_files[chunk_index], samples[sample_index].first, bounds[partition][chunk_index] ) )
+            return( false );
+     }
+   return( true );
+  }
+//+----------------------------------------------------+
+//|                   |
+//+----------------------------------------------------+
+template<class IntType,class ParallelSort>
+bool CExternalSort<IntType, ParallelSort>::MergeRange( const std::vector<std::string> &chunks, const std::string &output_file_name, const std::vector<size_t> &begin, const std::vector<size_t> &end, const size_t read_buffer_size, const size_t write_buffer_size, const EnReduce reduce, const size_t limit, size_t &written )
+  {
+//---      ,    
+   size_t output_offset = 0;
+   for( const auto &position : begin )
+      output_offset += position;
+   if( reduce == REDUCE_COUNT )
+      output_offset *= COUNT_ITEMS;
+   CDataChunk<IntType> output_file( m_io_service, m_memory, write_buffer_size );
+   if( !output_file.Open( output_file_name, CBinFile::MODE_WRITE | CBinFile::MODE_UPDATE | m_io_mode, output_offset * sizeof( IntType ) ) )
+      return( false );
 //---  
    typename CDataChunk<IntType>::PtrArray data_chunks;
-//---       
-   std::priority_queue<CDataChunkItem<IntType>, std::vector<CDataChunkItem<IntType>>, std::greater<CDataChunkItem<IntType>>> data_items;
-//---     
-   for( const auto &chunk_name : m_chunks )
+//---   ,   
+   for( size_t chunk_index = 0; chunk_index < chunks.size(); chunk_index++ )
      {
-      typename CDataChunk<IntType>::Ptr chunk( new CDataChunk<IntType>( m_io_service, ( RAM_MAX / 4 ) / m_chunks.size() ) );
-      if( !chunk->Open( chunk_name, CBinFile::MODE_READ | CBinFile::MODE_TEMP ) )
+      if( begin[chunk_index] >= end[chunk_index] )
+         continue;
+      //---      ,    
+      CRunFile<IntType> run;
+      size_t offset = 0, length = 0, skip = 0;
+      if( !run.Open( chunks[chunk_index] ) || !run.Range( begin[chunk_index], end[chunk_index], offset, length, skip ) )
         {
-         std::cerr << "failed to open chunk file " << chunk_name << std::endl;
+         std::cerr << "failed to open chunk file " << chunks[chunk_index] << std::endl;
+         return( false );
+        }
+      typename CDataChunk<IntType>::Ptr chunk( new CDataChunk<IntType>( m_io_service, m_memory, read_buffer_size ) );
+      const int mode = CBinFile::MODE_READ | m_io_mode;
+      if( run.Compressed() ? !chunk->OpenCompressed( chunks[chunk_index], mode, offset, length, skip, end[chunk_index] - begin[chunk_index] ) : !chunk->Open( chunks[chunk_index], mode, offset, length ) )
+        {
+         std::cerr << "failed to open chunk file " << chunks[chunk_index] << std::endl;
          return( false );
         }
       data_chunks.push_back( chunk );
      }
-//---       
-   for( const auto &chunk : data_chunks )
+//---    
+   const size_t sources_count = data_chunks.size();
+   std::vector<const IntType*> current_items( sources_count, nullptr ), end_items( sources_count, nullptr );
+//---        
+   CLoserTree<IntType> data_items;
+   data_items.Init( sources_count );
+   for( size_t source = 0; source < sources_count; source++ )
+      if( data_chunks[source]->ReadWindow( current_items[source], end_items[source] ) )
+         data_items.Set( source, *current_items[source] );
+   data_items.Build();
+//---     
+   IntType *output, *output_end;
+   if( !output_file.WriteWindow( output, output_end ) )
+      return( false );
+//---        :      
+   IntType key = IntType();
+   unsigned long long key_count = 0;
+   written = 0;
+//---    ()  
+   size_t left = limit;
+//---              
+   size_t last_source = sources_count;
+   while( !data_items.Empty() && left > 0 )
      {
-      CDataChunkItem<IntType> chunk_item( chunk );
-      if( chunk_item.Next() )
-         data_items.push( chunk_item );
+      const size_t source = data_items.TopSource();
+      const IntType* &current = current_items[source];
+      const IntType* last = current + 1;
+      //---    ,      ,    
+      if( source == last_source )
+        {
+         IntType runner_up;
+         last = data_items.RunnerUp( runner_up ) ? GallopUpperBound( last, end_items[source], runner_up ) : end_items[source];
+        }
+      //---    ,    
+      if( reduce != REDUCE_NONE )
+         for( ; current < last; current++ )
+           {
+            if( key_count > 0 && !( key < *current ) )
+              {
+               key_count++;
+               continue;
+              }
+            if( key_count > 0 )
+              {
+               if( !MergeEmit( output_file, output, output_end, key, key_count, reduce, written ) )
+                  return( false );
+               //---     
+               if( --left == 0 )
+                 {
+                  key_count = 0;
+                  break;
+                 }
+              }
+            key = *current;
+            key_count = 1;
+           }
+      if( left == 0 )
+         break;
+      //---      
+      if( reduce == REDUCE_NONE && (size_t) ( last - current ) > left )
+         last = current + left;
+      const IntType* copied = current;
+      //---     
+      if( last == current + 1 && output < output_end )
+         *output++ = *current++;
+      while( current < last )
+        {
+         if( output == output_end )
+           {
+            output_file.WriteCommit( output );
+            if( !output_file.WriteWindow( output, output_end ) )
+               return( false );
+           }
+         const size_t count = std::min<size_t>( last - current, output_end - output );
+         output = std::copy( current, current + count, output );
+         current += count;
+        }
+      if( reduce == REDUCE_NONE )
+         left -= current - copied;
+      //---   ,  
+      if( current == end_items[source] )
+        {
+         data_chunks[source]->ReadCommit( current );
+         if( !data_chunks[source]->ReadWindow( current, end_items[source] ) )
+           {
+            data_items.Pop();
+            last_source = sources_count;
+            continue;
+           }
+        }
+      data_items.Replace( *current );
+      last_source = source;
      }
-//---       
-   while( !data_items.empty() )
+//---   ,     ;     
+   if( key_count > 0 && left > 0 && !MergeEmit( output_file, output, output_end, key, key_count, reduce, written ) )
+      return( false );
+   if( reduce == REDUCE_NONE )
+      written = limit - left;
+//---       
+   output_file.WriteCommit( output );
+   output_file.Close();
+   return( true );
+  }
+//+----------------------------------------------------+
+//|                                |
+//+----------------------------------------------------+
+template<class IntType,class ParallelSort>
+bool CExternalSort<IntType, ParallelSort>::MergeEmit( CDataChunk<IntType> &output_file, IntType* &output, IntType* &output_end, const IntType &key, const unsigned long long count, const EnReduce reduce, size_t &written )
+  {
+   IntType item[COUNT_ITEMS];
+   size_t items = 1;
+   if( reduce == REDUCE_COUNT )
      {
-      CDataChunkItem<IntType> item = data_items.top();
-      data_items.pop();
-      if( !output_file.Write( item ) )
+      CountItem( key, count, item );
+      items = COUNT_ITEMS;
+     }
+   else
+      item[0] = key;
+//---      
+   for( size_t index = 0; index < items; index++ )
+     {
+      if( output == output_end )
         {
-         std::cerr << "failed to write to output file" << std::endl;
-         return( false );
+         output_file.WriteCommit( output );
+         if( !output_file.WriteWindow( output, output_end ) )
+            return( false );
         }
-      if( item.Next() )
-         data_items.push( item );
+      *output++ = item[index];
      }
+   written += items;
    return( true );
   }
 //+----------------------------------------------------+
+//|                                |
+//+----------------------------------------------------+
+template<class IntType,class ParallelSort>
+void CExternalSort<IntType, ParallelSort>::MergePartition( const std::vector<std::string> chunks, const std::string output_file_name, const std::vector<size_t> begin, const std::vector<size_t> end, const size_t read_buffer_size, const size_t write_buffer_size, const size_t partition )
+  {
+   CTraceScope trace( "merge partition" );
+   bool success = false;
+   try
+     {
+      success = MergeRange( chunks, output_file_name, begin, end, read_buffer_size, write_buffer_size, m_partitions_reduce, m_partitions_limit[partition], m_partitions_written[partition] );
+     }
+   catch( std::exception &ex )
+     {
+      std::cerr << "merge partition failed: " << ex.what() << std::endl;
+     }
+   MergePartitionComplete( success );
+  }
+//+----------------------------------------------------+
+//|                |
+//+----------------------------------------------------+
+template<class IntType,class ParallelSort>
+void CExternalSort<IntType, ParallelSort>::MergePartitionComplete( const bool success )
+  {
+   m_partitions_sync.lock();
+   m_partitions_merged++;
+   if( !success )
+      m_partitions_failed = true;
+   m_partitions_sync.unlock();
+   m_partitions_cond.notify_all();
+  }
+//+----------------------------------------------------+
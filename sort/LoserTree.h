@@ -0,0 +1,111 @@
+//+----------------------------------------------------+
+//| Author: Maxim Ulyanov <ulyanov.maxim@gmail.com>    |
+//+----------------------------------------------------+
+//+----------------------------------------------------+
+//|    k-           |
+//+----------------------------------------------------+
+template<class IntType = unsigned>
+class CLoserTree
+  {
+private:
+   //---   ( ,    )
+   size_t            m_leaves;
+   //---       
+   std::vector<IntType> m_keys;
+   std::vector<unsigned char> m_empty;
+   //---  : [0] - , [1, m_leaves) -    
+   std::vector<size_t> m_nodes;
+
+public:
+                     CLoserTree() : m_leaves( 1 ), m_keys( 1 ), m_empty( 1, 1 ), m_nodes( 1, 0 ) {}
+   //---     ,   
+   void              Init( const size_t sources_count );
+   //---    (  )
+   void              Set( const size_t source, const IntType &key ) { m_keys[source] = key; m_empty[source] = 0; }
+   //---      
+   void              Build();
+   //---   
+   bool              Empty() const { return( m_empty[m_nodes[0]] != 0 ); }
+   //---     
+   const IntType&    Top() const { return( m_keys[m_nodes[0]] ); }
+   size_t            TopSource() const { return( m_nodes[0] ); }
+   //---        
+   void              Replace( const IntType &key ) { m_keys[m_nodes[0]] = key; Replay(); }
+   //---    
+   void              Pop() { m_empty[m_nodes[0]] = 1; Replay(); }
+   //---     
+   bool              RunnerUp( IntType &key ) const;
+
+private:
+   //---  ,     
+   bool              Less( const size_t left, const size_t right ) const { return( !m_empty[left] && ( m_empty[right] || m_keys[left] < m_keys[right] ) ); }
+   //---      
+   void              Replay();
+  };
+//+----------------------------------------------------+
+//|                                       |
+//+----------------------------------------------------+
+template<class IntType>
+void CLoserTree<IntType>::Init( const size_t sources_count )
+  {
+   m_leaves = 1;
+   while( m_leaves < sources_count )
+      m_leaves <<= 1;
+   m_keys.assign( m_leaves, IntType() );
+   m_empty.assign( m_leaves, 1 );
+   m_nodes.assign( m_leaves, 0 );
+  }
+//+----------------------------------------------------+
+//|                                    |
+//+----------------------------------------------------+
+template<class IntType>
+void CLoserTree<IntType>::Build()
+  {
+//---       ,  - [m_leaves, 2 * m_leaves)
+   std::vector<size_t> winners( 2 * m_leaves );
+   for( size_t leaf = 0; leaf < m_leaves; leaf++ )
+      winners[m_leaves + leaf] = leaf;
+   for( size_t node = m_leaves - 1; node > 0; node-- )
+     {
+      const size_t left = winners[2 * node];
+      const size_t right = winners[2 * node + 1];
+      const bool right_wins = Less( right, left );
+      m_nodes[node] = right_wins ? left : right;
+      winners[node] = right_wins ? right : left;
+     }
+   m_nodes[0] = winners[1];
+  }
+//+----------------------------------------------------+
+//|                       |
+//+----------------------------------------------------+
+template<class IntType>
+void CLoserTree<IntType>::Replay()
+  {
+//---    ,   ;     
+   size_t winner = m_nodes[0];
+   for( size_t parent = ( m_leaves + winner ) >> 1; parent > 0; parent >>= 1 )
+     {
+      const size_t loser = m_nodes[parent];
+      const bool loser_wins = Less( loser, winner );
+      m_nodes[parent] = loser_wins ? winner : loser;
+      winner = loser_wins ? loser : winner;
+     }
+   m_nodes[0] = winner;
+  }
+//+----------------------------------------------------+
+//|             |
+//+----------------------------------------------------+
+template<class IntType>
+bool CLoserTree<IntType>::RunnerUp( IntType &key ) const
+  {
+//---       ,       
+   size_t runner_up = m_nodes[0];
+   for( size_t parent = ( m_leaves + m_nodes[0] ) >> 1; parent > 0; parent >>= 1 )
+      if( runner_up == m_nodes[0] ? !m_empty[m_nodes[parent]] : Less( m_nodes[parent], runner_up ) )
+         runner_up = m_nodes[parent];
+   if( runner_up == m_nodes[0] )
+      return( false );
+   key = m_keys[runner_up];
+   return( true );
+  }
+//+----------------------------------------------------+
@@ -0,0 +1,114 @@
+//+----------------------------------------------------+
+//| Author: Maxim Ulyanov <ulyanov.maxim@gmail.com>    |
+//+----------------------------------------------------+
+//+----------------------------------------------------+
+//|                         |
+//+----------------------------------------------------+
+class CMemoryBudget
+  {
+public:
+   //---    ,   O_DIRECT
+   static const size_t ALIGNMENT = 4096;
+   //---        
+   class CRelease
+     {
+   private:
+      CMemoryBudget    *m_budget;
+      size_t            m_size;
+
+   public:
+                        CRelease() : m_budget( nullptr ), m_size( 0 ) {}
+                        CRelease( CMemoryBudget *budget, const size_t size ) : m_budget( budget ), m_size( size ) {}
+      void              operator()( char* buffer ) const;
+     };
+   //--- ,   ;         
+   typedef std::unique_ptr<char[], CRelease> Buffer;
+
+private:
+   //--- ,      
+   const size_t      m_limit;
+   size_t            m_used;
+   size_t            m_peak;
+   boost::mutex      m_sync;
+
+public:
+                     CMemoryBudget( const size_t limit ) : m_limit( limit ), m_used( 0 ), m_peak( 0 ) {}
+   //--- 
+   size_t            Limit() const { return( m_limit ); }
+   size_t            Used();
+   size_t            Peak();
+   //---   ,    - 
+   Buffer            Allocate( const size_t size );
+
+private:
+   //---    
+   void              Release( const size_t size );
+  };
+//+----------------------------------------------------+
+//|                                  |
+//+----------------------------------------------------+
+void CMemoryBudget::CRelease::operator()( char* buffer ) const
+  {
+#ifdef _WIN32
+   _aligned_free( buffer );
+#else
+   free( buffer );
+#endif
+   if( m_budget != nullptr )
+      m_budget->Release( m_size );
+  }
+//+----------------------------------------------------+
+//|                       |
+//+----------------------------------------------------+
+size_t CMemoryBudget::Used()
+  {
+   boost::lock_guard<boost::mutex> lock( m_sync );
+   return( m_used );
+  }
+//+----------------------------------------------------+
+//|                  |
+//+----------------------------------------------------+
+size_t CMemoryBudget::Peak()
+  {
+   boost::lock_guard<boost::mutex> lock( m_sync );
+   return( m_peak );
+  }
+//+----------------------------------------------------+
+//|                                     |
+//+----------------------------------------------------+
+CMemoryBudget::Buffer CMemoryBudget::Allocate( const size_t size )
+  {
+//---    
+   m_sync.lock();
+   if( size > m_limit - m_used )
+     {
+      m_sync.unlock();
+      throw std::runtime_error( "memory budget exceeded" );
+     }
+   m_used += size;
+   m_peak = std::max( m_peak, m_used );
+   m_sync.unlock();
+//---  ,    
+   void* buffer = nullptr;
+#ifdef _WIN32
+   buffer = _aligned_malloc( std::max<size_t>( size, 1 ), ALIGNMENT );
+#else
+   if( posix_memalign( &buffer, ALIGNMENT, std::max<size_t>( size, 1 ) ) != 0 )
+      buffer = nullptr;
+#endif
+   if( buffer == nullptr )
+     {
+      Release( size );
+      throw std::bad_alloc();
+     }
+   return( Buffer( (char*) buffer, CRelease( this, size ) ) );
+  }
+//+----------------------------------------------------+
+//|                                |
+//+----------------------------------------------------+
+void CMemoryBudget::Release( const size_t size )
+  {
+   boost::lock_guard<boost::mutex> lock( m_sync );
+   m_used -= size;
+  }
+//+----------------------------------------------------+
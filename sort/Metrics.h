@@ -0,0 +1,244 @@
+//+----------------------------------------------------+
+//| Author: Maxim Ulyanov <ulyanov.maxim@gmail.com>    |
+//+----------------------------------------------------+
+//+----------------------------------------------------+
+//|                            |
+//+----------------------------------------------------+
+//|     ,    |
+//|                           |
+//+----------------------------------------------------+
+class CHistogram
+  {
+public:
+   static const int  BUCKETS = 40;
+
+private:
+   //---  b -   2^b 
+   std::atomic<unsigned long long> m_buckets[BUCKETS];
+   std::atomic<unsigned long long> m_count;
+   std::atomic<unsigned long long> m_sum;
+   std::atomic<unsigned long long> m_min;
+   std::atomic<unsigned long long> m_max;
+
+public:
+                     CHistogram();
+   void              Add( const unsigned long long value );
+   unsigned long long Count() const { return( m_count.load( std::memory_order_relaxed ) ); }
+   unsigned long long Sum() const { return( m_sum.load( std::memory_order_relaxed ) ); }
+   //---  JSON
+   void              Report( std::ostream &out ) const;
+  };
+//+----------------------------------------------------+
+//|                                         |
+//+----------------------------------------------------+
+CHistogram::CHistogram() : m_count( 0 ), m_sum( 0 ), m_min( std::numeric_limits<unsigned long long>::max() ), m_max( 0 )
+  {
+   for( int bucket = 0; bucket < BUCKETS; bucket++ )
+      m_buckets[bucket] = 0;
+  }
+//+----------------------------------------------------+
+//|                                  |
+//+----------------------------------------------------+
+void CHistogram::Add( const unsigned long long value )
+  {
+   int bucket = 0;
+   while( bucket < BUCKETS - 1 && ( value >> bucket ) != 0 )
+      bucket++;
+   m_buckets[bucket].fetch_add( 1, std::memory_order_relaxed );
+   m_count.fetch_add( 1, std::memory_order_relaxed );
+   m_sum.fetch_add( value, std::memory_order_relaxed );
+//---     ,       
+   unsigned long long current = m_min.load( std::memory_order_relaxed );
+   while( value < current && !m_min.compare_exchange_weak( current, value, std::memory_order_relaxed ) )
+      ;
+   current = m_max.load( std::memory_order_relaxed );
+   while( value > current && !m_max.compare_exchange_weak( current, value, std::memory_order_relaxed ) )
+      ;
+  }
+//+----------------------------------------------------+
+//|                                               |
+//+----------------------------------------------------+
+void CHistogram::Report( std::ostream &out ) const
+  {
+   const unsigned long long count = Count();
+   out << "{ \"count\": " << count << ", \"sum_us\": " << Sum() << ", \"min_us\": " << ( count > 0 ? m_min.load() : 0 ) << ", \"max_us\": " << m_max.load() << ", \"buckets\": [";
+//---   ,  - 
+   bool first = true;
+   for( int bucket = 0; bucket < BUCKETS; bucket++ )
+     {
+      const unsigned long long bucket_count = m_buckets[bucket].load( std::memory_order_relaxed );
+      if( bucket_count == 0 )
+         continue;
+      out << ( first ? " " : ", " ) << "{ \"lt_us\": " << ( 1ull << bucket ) << ", \"count\": " << bucket_count << " }";
+      first = false;
+     }
+   out << " ] }";
+  }
+//+----------------------------------------------------+
+//|                                   |
+//+----------------------------------------------------+
+//|      :       |
+//|       , -    |
+//|                        |
+//+----------------------------------------------------+
+class CMetrics
+  {
+public:
+   enum EnPhase
+     {
+      PHASE_OTHER = 0,
+      PHASE_IN_MEMORY,
+      PHASE_SPLIT,
+      PHASE_MERGE_PASS,
+      PHASE_MERGE,
+      PHASE_SELECT,
+      PHASE_COUNT
+     };
+
+private:
+   //---  
+   struct SPhase
+     {
+      std::atomic<unsigned long long> time_us;
+      std::atomic<unsigned long long> bytes_read;
+      std::atomic<unsigned long long> bytes_written;
+      std::atomic<unsigned long long> elements_merged;
+      CHistogram     async_wait;
+     };
+   SPhase            m_phases[PHASE_COUNT];
+   std::atomic<int>  m_phase;
+   //---  :  ,       
+   std::atomic<unsigned long long> m_runs;
+   std::atomic<unsigned long long> m_elements_sorted;
+   CHistogram        m_run_sort;
+   //--- : ,   ,  ,         
+   std::atomic<unsigned long long> m_merge_passes;
+   unsigned long long m_merges;
+   size_t            m_merge_fan_in;
+   size_t            m_merge_read_buffer;
+   size_t            m_merge_partitions;
+   //---       
+   size_t            m_memory_limit;
+   size_t            m_memory_peak;
+
+public:
+   static CMetrics  &Instance() { static CMetrics metrics; return( metrics ); }
+   //---      
+   static unsigned long long Now() { return( (unsigned long long) std::chrono::duration_cast<std::chrono::microseconds>( std::chrono::steady_clock::now().time_since_epoch() ).count() ); }
+   //--- -  
+   void              BytesRead( const size_t size ) { Phase().bytes_read.fetch_add( size, std::memory_order_relaxed ); }
+   void              BytesWritten( const size_t size ) { Phase().bytes_written.fetch_add( size, std::memory_order_relaxed ); }
+   void              AsyncWait( const unsigned long long time_us ) { Phase().async_wait.Add( time_us ); }
+   void              ElementsMerged( const size_t count ) { Phase().elements_merged.fetch_add( count, std::memory_order_relaxed ); }
+   //---    
+   void              RunSorted( const size_t count, const unsigned long long time_us ) { m_elements_sorted.fetch_add( count, std::memory_order_relaxed ); m_run_sort.Add( time_us ); }
+   void              RunAdded() { m_runs.fetch_add( 1, std::memory_order_relaxed ); }
+   //---      ,    
+   void              MergePass() { m_merge_passes.fetch_add( 1, std::memory_order_relaxed ); }
+   void              MergeStarted( const size_t fan_in, const size_t partitions, const size_t read_buffer_size );
+   void              Memory( const size_t limit, const size_t peak ) { m_memory_limit = limit; m_memory_peak = peak; }
+   //---  JSON
+   bool              Report( const std::string &file_name ) const;
+
+private:
+                     CMetrics();
+   friend class      CMetricsPhase;
+   SPhase           &Phase() { return( m_phases[m_phase.load( std::memory_order_relaxed )] ); }
+   static const char* PhaseName( const int phase );
+  };
+//+----------------------------------------------------+
+//|                                         |
+//+----------------------------------------------------+
+CMetrics::CMetrics() : m_phase( PHASE_OTHER ), m_runs( 0 ), m_elements_sorted( 0 ), m_merge_passes( 0 ), m_merges( 0 ), m_merge_fan_in( 0 ), m_merge_read_buffer( 0 ), m_merge_partitions( 0 ), m_memory_limit( 0 ), m_memory_peak( 0 )
+  {
+   for( int phase = 0; phase < PHASE_COUNT; phase++ )
+     {
+      m_phases[phase].time_us = 0;
+      m_phases[phase].bytes_read = 0;
+      m_phases[phase].bytes_written = 0;
+      m_phases[phase].elements_merged = 0;
+     }
+  }
+//+----------------------------------------------------+
+//|                                 |
+//+----------------------------------------------------+
+void CMetrics::MergeStarted( const size_t fan_in, const size_t partitions, const size_t read_buffer_size )
+  {
+   if( m_merges == 0 || read_buffer_size < m_merge_read_buffer )
+     {
+      m_merge_read_buffer = read_buffer_size;
+      m_merge_partitions = partitions;
+     }
+   m_merge_fan_in = std::max( m_merge_fan_in, fan_in );
+   m_merges++;
+  }
+//+----------------------------------------------------+
+//|                                     |
+//+----------------------------------------------------+
+const char* CMetrics::PhaseName( const int phase )
+  {
+   static const char* names[PHASE_COUNT] = { "other", "in_memory", "split", "merge_pass", "merge", "select" };
+   return( names[phase] );
+  }
+//+----------------------------------------------------+
+//|                                               |
+//+----------------------------------------------------+
+bool CMetrics::Report( const std::string &file_name ) const
+  {
+   std::ofstream out( file_name.c_str() );
+   if( !out )
+      return( false );
+   out << "{" << std::endl << "  \"phases\": {";
+//--- ,   , 
+   bool first = true;
+   for( int phase = 0; phase < PHASE_COUNT; phase++ )
+     {
+      const SPhase &data = m_phases[phase];
+      const unsigned long long time_us = data.time_us.load();
+      if( time_us == 0 && data.bytes_read.load() == 0 && data.bytes_written.load() == 0 )
+         continue;
+      const unsigned long long elements = data.elements_merged.load();
+      out << ( first ? "" : "," ) << std::endl << "    \"" << PhaseName( phase ) << "\": { \"time_ms\": " << time_us / 1000.0;
+      out << ", \"bytes_read\": " << data.bytes_read.load() << ", \"bytes_written\": " << data.bytes_written.load();
+      out << ", \"async_wait_ms\": " << data.async_wait.Sum() / 1000.0;
+      if( elements > 0 )
+         out << ", \"elements_merged\": " << elements << ", \"merge_elements_per_second\": " << ( time_us > 0 ? (unsigned long long) ( elements * 1e6 / time_us ) : 0 );
+      out << "," << std::endl << "      \"async_wait\": ";
+      data.async_wait.Report( out );
+      out << " }";
+      first = false;
+     }
+   out << std::endl << "  }," << std::endl;
+//---  
+   const unsigned long long sorted = m_elements_sorted.load();
+   const unsigned long long sort_us = m_run_sort.Sum();
+   out << "  \"runs\": " << m_runs.load() << "," << std::endl;
+   out << "  \"elements_sorted\": " << sorted << "," << std::endl;
+   out << "  \"sort_elements_per_second\": " << ( sort_us > 0 ? (unsigned long long) ( sorted * 1e6 / sort_us ) : 0 ) << "," << std::endl;
+   out << "  \"run_sort\": ";
+   m_run_sort.Report( out );
+   out << "," << std::endl;
+   out << "  \"merge\": { \"passes\": " << m_merge_passes.load() << ", \"merges\": " << m_merges << ", \"fan_in_max\": " << m_merge_fan_in;
+   out << ", \"read_buffer_min\": " << m_merge_read_buffer << ", \"partitions\": " << m_merge_partitions << " }," << std::endl;
+   out << "  \"memory\": { \"limit\": " << m_memory_limit << ", \"peak\": " << m_memory_peak << " }" << std::endl << "}" << std::endl;
+   return( !out.fail() );
+  }
+//+----------------------------------------------------+
+//|                                      |
+//+----------------------------------------------------+
+//|     -        |
+//| ,      ;   |
+//|                  |
+//+----------------------------------------------------+
+class CMetricsPhase
+  {
+private:
+   const int         m_phase;
+   const int         m_previous;
+   const unsigned long long m_start;
+
+public:
+                     CMetricsPhase( const CMetrics::EnPhase phase ) : m_phase( phase ), m_previous( CMetrics::Instance().m_phase.exchange( phase ) ), m_start( CMetrics::Now() ) {}
+                    ~CMetricsPhase() { if( m_phase != m_previous ) CMetrics::Instance().m_phases[m_phase].time_us.fetch_add( CMetrics::Now() - m_start ); CMetrics::Instance().m_phase = m_previous; }
+  };
+//+----------------------------------------------------+
@@ -17,7 +17,11 @@ public:
                      CParallelSort( boost::asio::io_service &io, const int concurrency_level ) : m_io_service( io ), m_concurrency_level( concurrency_level ) {}
    virtual          ~CParallelSort() {}
    //---   (  ,          )
-   bool              Sort( IntType* begin, IntType* end, IntType* result) { return( SortImpl( begin, end, result ) ); }
+   bool              Sort( IntType* begin, IntType* end, IntType* result );
+   //---    (,  ), scratch -     
+   bool              Sort( const IntType* begin, const IntType* end, IntType* result, IntType* scratch );
+   //---   : Sort( begin, end, begin )    ,     - 
+   virtual bool      InPlace() const { return( false ); }
 
 protected:
    //---  
@@ -28,8 +32,48 @@ protected:
 private:
    //---  
    virtual bool      SortImpl( IntType* begin, IntType* end, IntType* result ) = 0;
+   //---        
+   virtual bool      SortConstImpl( const IntType* begin, const IntType* end, IntType* result, IntType* scratch );
   };
 //+----------------------------------------------------+
+//|                                    |
+//+----------------------------------------------------+
+template<class IntType>
+bool CParallelSort<IntType>::Sort( IntType* begin, IntType* end, IntType* result )
+  {
+   CTraceScope trace( "sort" );
+   const unsigned long long start = CMetrics::Now();
+   const bool sorted = SortImpl( begin, end, result );
+//---     
+   if( sorted )
+      CMetrics::Instance().RunSorted( end - begin, CMetrics::Now() - start );
+   return( sorted );
+  }
+//+----------------------------------------------------+
+//|                        |
+//+----------------------------------------------------+
+template<class IntType>
+bool CParallelSort<IntType>::Sort( const IntType* begin, const IntType* end, IntType* result, IntType* scratch )
+  {
+   CTraceScope trace( "sort" );
+   const unsigned long long start = CMetrics::Now();
+   const bool sorted = SortConstImpl( begin, end, result, scratch );
+   if( sorted )
+      CMetrics::Instance().RunSorted( end - begin, CMetrics::Now() - start );
+   return( sorted );
+  }
+//+----------------------------------------------------+
+//|                        |
+//+----------------------------------------------------+
+template<class IntType>
+bool CParallelSort<IntType>::SortConstImpl( const IntType* begin, const IntType* end, IntType* result, IntType* scratch )
+  {
+   if( begin == nullptr || end == nullptr || scratch == nullptr || begin > end )
+      return( false );
+   memcpy( scratch, begin, ( end - begin ) * sizeof( IntType ) );
+   return( SortImpl( scratch, scratch + ( end - begin ), result ) );
+  }
+//+----------------------------------------------------+
 //|             |
 //+----------------------------------------------------+
 template<class IntType = unsigned>
@@ -49,6 +93,8 @@ private:
    virtual bool      SortImpl( IntType* begin, IntType* end, IntType* result );
    //---   
    void              SerialSort( IntType* chunk_begin, IntType* chunk_end );
+   //---     
+   void              SerialMerge( const IntType* chunk_begin, const IntType* chunk_middle, const IntType* chunk_end, IntType* result );
    void              SerialSortComplete() { m_chunks_sorted_sync.lock(); m_chunks_sorted++; m_chunks_sorted_sync.unlock(); m_chunks_sorted_cond.notify_all(); }
    //--- /  
    void              SortStart() { m_chunks_sorted_sync.lock(); m_chunks_sorted = 0; m_chunks_sorted_sync.unlock(); }
@@ -84,18 +130,37 @@ bool CParallelSortLinearMerge<IntType>::SortImpl( IntType* begin, IntType* end,
          CParallelSort<IntType>::IOService().post( boost::bind( &CParallelSortLinearMerge::SerialSort, this, bound[chunk_index], bound[chunk_index + 1] ) );
      }
    SortWait( chunks_count );
-//---   
-   std::vector<IntType*> chunk( bound );
-   chunk.pop_back();
-   for( IntType* current = result; current < result + ( end - begin ); current++ )
-     {
-      int chunk_min = -1;
-      for( int chunk_index = 0; chunk_index < chunk.size(); chunk_index++ )
-         if( chunk[chunk_index] < bound[chunk_index + 1] && ( chunk_min < 0 || *chunk[chunk_index] < *chunk[chunk_min] ) )
-            chunk_min = chunk_index;
-      *current = *chunk[chunk_min];
-      chunk[chunk_min]++;
+//---    ,     ;   
+   std::vector<size_t> offsets;
+   for( int bound_index = 0; bound_index <= chunks_count; bound_index++ )
+      offsets.push_back( bound[bound_index] - begin );
+   IntType* source = begin;
+   IntType* target = result;
+   while( offsets.size() > 2 )
+     {
+      std::vector<size_t> merged;
+      int merges_count = 0;
+      size_t index = 0;
+      SortStart();
+      for( ; index + 2 < offsets.size(); index += 2 )
+        {
+         CParallelSort<IntType>::IOService().post( boost::bind( &CParallelSortLinearMerge::SerialMerge, this, source + offsets[index], source + offsets[index + 1], source + offsets[index + 2], target + offsets[index] ) );
+         merged.push_back( offsets[index] );
+         merges_count++;
+        }
+      //---         
+      if( index + 2 == offsets.size() )
+        {
+         memcpy( target + offsets[index], source + offsets[index], ( offsets[index + 1] - offsets[index] ) * sizeof( IntType ) );
+         merged.push_back( offsets[index] );
+        }
+      merged.push_back( end - begin );
+      SortWait( merges_count );
+      offsets.swap( merged );
+      std::swap( source, target );
      }
+   if( source != result )
+      memcpy( result, source, ( end - begin ) * sizeof( IntType ) );
 //--- ok
    return( true );
   }
@@ -105,13 +170,24 @@ bool CParallelSortLinearMerge<IntType>::SortImpl( IntType* begin, IntType* end,
 template<class IntType>
 void CParallelSortLinearMerge<IntType>::SerialSort( IntType* chunk_begin, IntType* chunk_end )
   {
+   CTraceScope trace( "serial sort" );
    if( chunk_begin == nullptr || chunk_end == nullptr || chunk_begin > chunk_end )
       return;
-   std::sort( chunk_begin, chunk_end );
+   SLeafSort<IntType>::Sort( chunk_begin, chunk_end );
 //---    
    SerialSortComplete();
   }
 //+----------------------------------------------------+
+//|                              |
+//+----------------------------------------------------+
+template<class IntType>
+void CParallelSortLinearMerge<IntType>::SerialMerge( const IntType* chunk_begin, const IntType* chunk_middle, const IntType* chunk_end, IntType* result )
+  {
+   CTraceScope trace( "serial merge" );
+   SLeafSort<IntType>::Merge( chunk_begin, chunk_middle, chunk_middle, chunk_end, result );
+   SerialSortComplete();
+  }
+//+----------------------------------------------------+
 //|                        |
 //+----------------------------------------------------+
 template<class IntType>
@@ -123,19 +199,18 @@ void CParallelSortLinearMerge<IntType>::SortWait( const int chunks_count )
       m_chunks_sorted_cond.wait( lock );
   }
 //+----------------------------------------------------+
-//|                       |
+//|          |
 //+----------------------------------------------------+
 template<class IntType = unsigned>
 class CParallelQuickSort : public CParallelSort<IntType>
   {
 private:
-   //---   
-   size_t            m_chunk_min_size;
-   //---   
-   int               m_chunks_total;
-   int               m_chunks_sorted;
-   boost::mutex      m_chunks_sorted_sync;
-   boost::condition_variable m_chunks_sorted_cond;
+   //---   ,  ,     
+   static const size_t LEAF_MIN = 16 * 1024;
+   static const size_t LEAVES_PER_WORKER = 64;
+   typedef CWorkStealing<IntType, CParallelQuickSort> Tasks;
+   //---    
+   size_t            m_leaf_size;
 
 public:
                      CParallelQuickSort( boost::asio::io_service &io, const int concurrency_level );
@@ -143,21 +218,18 @@ public:
 private:
    //---   
    virtual bool      SortImpl( IntType* begin, IntType* end, IntType* result );
-   //---  
-   void              QuickSort( IntType* begin, IntType* end );
-   //---     
-   void              QuickSortAdd() { m_chunks_sorted_sync.lock(); m_chunks_total++; m_chunks_sorted_sync.unlock(); }
-   //---     
-   void              QuickSortComplete() { m_chunks_sorted_sync.lock(); m_chunks_sorted++; m_chunks_sorted_sync.unlock(); m_chunks_sorted_cond.notify_all(); }
-   //--- /  
-   void              SortStart() { m_chunks_sorted_sync.lock(); m_chunks_total = 0; m_chunks_sorted = 0; m_chunks_sorted_sync.unlock(); }
-   void              SortWait();
+   //---         
+   virtual bool      SortConstImpl( const IntType* begin, const IntType* end, IntType* result, IntType* scratch );
+   //---    
+   void              SortInPlace( IntType* begin, IntType* end );
+   //---   :     ,    
+   void              QuickSort( Tasks &tasks, const size_t worker, IntType* begin, IntType* end );
   };
 //+----------------------------------------------------+
 //|                                         |
 //+----------------------------------------------------+
 template<class IntType>
-CParallelQuickSort<IntType>::CParallelQuickSort( boost::asio::io_service &io, const int concurrency_level ) : CParallelSort<IntType>( io, concurrency_level ), m_chunks_total( 0 ), m_chunks_sorted( 0 )
+CParallelQuickSort<IntType>::CParallelQuickSort( boost::asio::io_service &io, const int concurrency_level ) : CParallelSort<IntType>( io, concurrency_level ), m_leaf_size( 0 )
   {
   }
 //+----------------------------------------------------+
@@ -168,33 +240,53 @@ bool CParallelQuickSort<IntType>::SortImpl( IntType* begin, IntType* end, IntTyp
   {
    if( begin == nullptr || end == nullptr || result == nullptr || begin > end )
       return( false );
-//---    ,   
-//--- TODO:       
-   m_chunk_min_size = ( end - begin ) / CParallelSort<IntType>::ConcurrencyLevel();
-//---   
-   SortStart();
-     {
-      QuickSortAdd();
-      //---          
-      CParallelSort<IntType>::IOService().post( boost::bind( &CParallelQuickSort::QuickSort, this, begin, end ) );
-     }
-   SortWait();
+   SortInPlace( begin, end );
 //---  
    memcpy( result, begin, (end - begin) * sizeof( IntType ) );
    return( true );
   }
 //+----------------------------------------------------+
-//|                                   |
+//|                        |
 //+----------------------------------------------------+
 template<class IntType>
-void CParallelQuickSort<IntType>::QuickSort( IntType* begin, IntType* end )
+bool CParallelQuickSort<IntType>::SortConstImpl( const IntType* begin, const IntType* end, IntType* result, IntType* scratch )
   {
-   if( begin == nullptr || end == nullptr || begin > end )
+   if( begin == nullptr || end == nullptr || result == nullptr || begin > end )
+      return( false );
+//---    -    
+   memcpy( result, begin, (end - begin) * sizeof( IntType ) );
+   SortInPlace( result, result + ( end - begin ) );
+   return( true );
+  }
+//+----------------------------------------------------+
+//|                       |
+//+----------------------------------------------------+
+template<class IntType>
+void CParallelQuickSort<IntType>::SortInPlace( IntType* begin, IntType* end )
+  {
+//---  ,   ;   -   
+   const size_t workers = std::max( 1, CParallelSort<IntType>::ConcurrencyLevel() / CONCURRENCY_MULTIPLIER );
+   const size_t total = end - begin;
+   if( workers == 1 || total < 2 * LEAF_MIN )
+     {
+      SLeafSort<IntType>::Sort( begin, end );
       return;
-//---     ,  
-   if( ( size_t )( end - begin ) < m_chunk_min_size )
-      std::sort( begin, end );
-   else
+     }
+//---  -   LEAF_MIN,    ,       :
+//---       
+   m_leaf_size = std::max( (size_t) LEAF_MIN, total / ( workers * LEAVES_PER_WORKER ) );
+   typename Tasks::Ptr tasks( new Tasks( this, &CParallelQuickSort::QuickSort, workers ) );
+   tasks->Spawn( 0, begin, end );
+   Tasks::Run( CParallelSort<IntType>::IOService(), tasks );
+  }
+//+----------------------------------------------------+
+//|                                   |
+//+----------------------------------------------------+
+template<class IntType>
+void CParallelQuickSort<IntType>::QuickSort( Tasks &tasks, const size_t worker, IntType* begin, IntType* end )
+  {
+   CTraceScope trace( "quick sort" );
+   while( ( size_t )( end - begin ) >= m_leaf_size )
      {
       //--- TODO:   
       IntType pivot = begin[( end - begin ) / 2];
@@ -214,28 +306,848 @@ void CParallelQuickSort<IntType>::QuickSort( IntType* begin, IntType* end )
             right--;
            }
         } while( left <= right );
-      if( begin < right )
+      //---    ,   -    
+      IntType* small_begin = begin;
+      IntType* small_end = right + 1;
+      IntType* large_begin = left;
+      IntType* large_end = end;
+      if( small_end - small_begin > large_end - large_begin )
         {
-         QuickSortAdd();
-         CParallelSort<IntType>::IOService().post( boost::bind( &CParallelQuickSort::QuickSort, this, begin, right + 1 ) );
+         std::swap( small_begin, large_begin );
+         std::swap( small_end, large_end );
         }
-      if( left < end - 1 )
+      tasks.Spawn( worker, large_begin, large_end );
+      begin = small_begin;
+      end = small_end;
+     }
+//---   
+   SLeafSort<IntType>::Sort( begin, end );
+  }
+//---   ,      ; GCC  -O2    
+#if defined( __GNUC__ ) && !defined( __clang__ )
+#define SAMPLE_SORT_UNROLL _Pragma( "GCC unroll 8" )
+#else
+#define SAMPLE_SORT_UNROLL
+#endif
+//+----------------------------------------------------+
+//|        |
+//|   (IPS4o)                                   |
+//+----------------------------------------------------+
+//|        |
+//|    ,   |
+//|         |
+//|  ;   -      |
+//| ,    .        |
+//|    :       |
+//|                     |
+//+----------------------------------------------------+
+template<class IntType = unsigned>
+class CParallelSampleSort : public CParallelSort<IntType>
+  {
+private:
+   //---   2^MAX_LOG_BUCKETS ,        
+   static const size_t MAX_LOG_BUCKETS = 8;
+   static const size_t MAX_BUCKETS = size_t( 1 ) << MAX_LOG_BUCKETS;
+   //---    
+   static const size_t OVERSAMPLING = 16;
+   //---    BASE_CASE  
+   static const size_t BASE_CASE = 16 * 1024;
+   //---  -  ,  2 
+   static const size_t BLOCK = 2048 / sizeof( IntType ) > 0 ? 2048 / sizeof( IntType ) : 1;
+   //--- ,  
+   static const size_t UNROLL = 8;
+   //---   :  ,     ,     
+   //---       
+   static const size_t SWAP_BLOCK = 2 * MAX_BUCKETS;
+   static const size_t OVERFLOW_BLOCK = SWAP_BLOCK + 2;
+   static const size_t SAVED_BLOCK = OVERFLOW_BLOCK + 1;
+   static const size_t WORKER_BLOCKS = SAVED_BLOCK + 1;
+   typedef CWorkStealing<IntType, CParallelSampleSort> Tasks;
+   //--- :       
+   struct SClassifier
+     {
+      IntType        tree[MAX_BUCKETS];
+      IntType        lower[MAX_BUCKETS];
+      size_t         log_buckets;
+      size_t         buckets;
+     };
+   //---    :    32 ,   ,  ;  
+   //---   ;     
+   struct SPointers
+     {
+      std::atomic<unsigned long long> position;
+      std::atomic<size_t> reading;
+      char           padding[64 - sizeof( std::atomic<unsigned long long> ) - sizeof( std::atomic<size_t> )];
+     };
+   //---   :   ,      ;  ,
+   //---   , -    ,   ,     
+   struct SWorker
+     {
+      SClassifier    classifier;
+      std::unique_ptr<IntType[]> blocks;
+      size_t         fill[2 * MAX_BUCKETS];
+      size_t         full[2 * MAX_BUCKETS];
+      IntType       *stripe_begin;
+      IntType       *written;
+      IntType       *begin;
+      IntType       *end;
+      size_t         bounds[2 * MAX_BUCKETS + 1];
+      size_t         slots[2 * MAX_BUCKETS + 1];
+      SPointers      pointers[2 * MAX_BUCKETS];
+      size_t         overflow;
+      size_t         saved;
+     };
+   //---       worker  [first, first + count)
+   typedef void      ( CParallelSampleSort::*Phase )( const size_t first, const size_t count, const size_t worker );
+   std::unique_ptr<SWorker[]> m_workers;
+   size_t            m_workers_count;
+   //---      
+   size_t            m_phase_completed;
+   boost::mutex      m_phase_completed_sync;
+   boost::condition_variable m_phase_completed_cond;
+
+public:
+                     CParallelSampleSort( boost::asio::io_service &io, const int concurrency_level );
+   virtual bool      InPlace() const { return( true ); }
+
+private:
+   //---  :  ,  ,       
+   virtual bool      SortImpl( IntType* begin, IntType* end, IntType* result );
+   //---         
+   virtual bool      SortConstImpl( const IntType* begin, const IntType* end, IntType* result, IntType* scratch );
+   //---  
+   static size_t     Workers( const int concurrency_level ) { return( std::max( 1, concurrency_level / CONCURRENCY_MULTIPLIER ) ); }
+   //---    
+   void              SortInPlace( IntType* begin, IntType* end );
+   //---  :   ,     
+   void              SampleSort( Tasks &tasks, const size_t worker, IntType* begin, IntType* end );
+   //---      
+   static void       ClassifierBuild( SClassifier &classifier, IntType* begin, IntType* end );
+   static void       TreeBuild( SClassifier &classifier, const size_t node, const size_t low, const size_t high );
+   //---     :   -   
+   static size_t     Bucket( const SClassifier &classifier, const IntType &item, const size_t leaf ) { const size_t eq = ( leaf > 0 ) & !( classifier.lower[leaf] < item ); return( 2 * leaf + 1 - eq ); }
+   static size_t     Bucket( const SClassifier &classifier, const IntType &item );
+   //---     ,      
+   static void       Push( SWorker &data, const size_t bucket, const IntType &item, IntType* &written );
+   void              StripeClassify( const SClassifier &classifier, const size_t worker, IntType* begin, IntType* end );
+   //---    :    ,    
+   void              PhaseRun( const Phase phase, const char* name, const size_t count );
+   void              PhaseTask( const Phase phase, const char* name, const size_t count, const size_t worker );
+   //---    ,      
+   static IntType*   StripeBegin( const SWorker &owner, const size_t stripe, const size_t count );
+   void              StripeTask( const size_t first, const size_t count, const size_t worker );
+   //---      [first, first + count)   , bounds -     
+   void              Distribute( const size_t first, const size_t count, size_t* bounds );
+   //---  ,   
+   static void       BucketsRange( const size_t buckets, const size_t count, const size_t index, size_t &low, size_t &high );
+   //---     
+   bool              BlockFull( const size_t first, const size_t count, const size_t slot ) const;
+   //---           
+   void              BucketsGather( const size_t first, const size_t count, const size_t worker );
+   //---    
+   void              Permute( const size_t first, const size_t count, const size_t worker );
+   static bool       BlockRead( SWorker &owner, const size_t bucket, IntType* block );
+   static void       BlockWrite( SWorker &owner, const size_t slot, const IntType* block );
+   //---       
+   static size_t     Overflow( const SWorker &owner, const size_t bucket );
+   //---          
+   void              BucketsCleanup( const size_t first, const size_t count, const size_t worker );
+   static void       GapsCopy( IntType** gaps, const IntType* source, size_t count );
+  };
+//+----------------------------------------------------+
+//|                                         |
+//+----------------------------------------------------+
+template<class IntType>
+CParallelSampleSort<IntType>::CParallelSampleSort( boost::asio::io_service &io, const int concurrency_level ) : CParallelSort<IntType>( io, concurrency_level ), m_workers_count( 0 ), m_phase_completed( 0 )
+  {
+  }
+//+----------------------------------------------------+
+//|                                    |
+//+----------------------------------------------------+
+template<class IntType>
+bool CParallelSampleSort<IntType>::SortImpl( IntType* begin, IntType* end, IntType* result )
+  {
+   if( begin == nullptr || end == nullptr || result == nullptr || begin > end )
+      return( false );
+   SortInPlace( begin, end );
+   if( result != begin )
+      memcpy( result, begin, ( end - begin ) * sizeof( IntType ) );
+   return( true );
+  }
+//+----------------------------------------------------+
+//|                        |
+//+----------------------------------------------------+
+template<class IntType>
+bool CParallelSampleSort<IntType>::SortConstImpl( const IntType* begin, const IntType* end, IntType* result, IntType* scratch )
+  {
+   if( begin == nullptr || end == nullptr || result == nullptr || begin > end )
+      return( false );
+   memcpy( result, begin, ( end - begin ) * sizeof( IntType ) );
+   SortInPlace( result, result + ( end - begin ) );
+   return( true );
+  }
+//+----------------------------------------------------+
+//|                       |
+//+----------------------------------------------------+
+template<class IntType>
+void CParallelSampleSort<IntType>::SortInPlace( IntType* begin, IntType* end )
+  {
+   const size_t workers = Workers( CParallelSort<IntType>::ConcurrencyLevel() );
+   const size_t total = end - begin;
+   if( total <= BASE_CASE )
+     {
+      SLeafSort<IntType>::Sort( begin, end );
+      return;
+     }
+//---          
+   if( m_workers_count < workers )
+     {
+      m_workers.reset( new SWorker[workers] );
+      for( size_t worker = 0; worker < workers; worker++ )
+         m_workers[worker].blocks.reset( new IntType[WORKER_BLOCKS * BLOCK] );
+      m_workers_count = workers;
+     }
+   typename Tasks::Ptr tasks( new Tasks( this, &CParallelSampleSort::SampleSort, workers ) );
+   if( workers == 1 )
+     {
+      tasks->Spawn( 0, begin, end );
+      Tasks::Run( CParallelSort<IntType>::IOService(), tasks );
+      return;
+     }
+//---     ,   ;    0
+   SWorker &owner = m_workers[0];
+   ClassifierBuild( owner.classifier, begin, end );
+   owner.begin = begin;
+   owner.end = end;
+   PhaseRun( &CParallelSampleSort::StripeTask, "sample sort stripe", workers );
+   size_t bounds[2 * MAX_BUCKETS + 1];
+   Distribute( 0, workers, bounds );
+//---       ,      
+   for( size_t bucket = 0; bucket < 2 * owner.classifier.buckets; bucket++ )
+     {
+      const size_t size = bounds[bucket + 1] - bounds[bucket];
+      if( bucket % 2 == 1 && size > 1 )
+         tasks->Spawn( bucket / 2 % workers, begin + bounds[bucket], begin + bounds[bucket + 1] );
+     }
+   Tasks::Run( CParallelSort<IntType>::IOService(), tasks );
+  }
+//+----------------------------------------------------+
+//|                                     |
+//+----------------------------------------------------+
+template<class IntType>
+void CParallelSampleSort<IntType>::SampleSort( Tasks &tasks, const size_t worker, IntType* begin, IntType* end )
+  {
+   CTraceScope trace( "sample sort" );
+   if( ( size_t )( end - begin ) <= BASE_CASE )
+     {
+      SLeafSort<IntType>::Sort( begin, end );
+      return;
+     }
+   SWorker &data = m_workers[worker];
+   ClassifierBuild( data.classifier, begin, end );
+   data.begin = begin;
+   data.end = end;
+   StripeClassify( data.classifier, worker, begin, end );
+//---    :         
+   size_t bounds[2 * MAX_BUCKETS + 1];
+   const size_t buckets = 2 * data.classifier.buckets;
+   Distribute( worker, 1, bounds );
+   for( size_t bucket = 0; bucket < buckets; bucket++ )
+     {
+      IntType* bucket_begin = begin + bounds[bucket];
+      IntType* bucket_end = begin + bounds[bucket + 1];
+      if( bucket_begin == bucket_end || bucket % 2 == 0 )
+         continue;
+      if( ( size_t )( bucket_end - bucket_begin ) <= BASE_CASE )
+         SLeafSort<IntType>::Sort( bucket_begin, bucket_end );
+      else
+         tasks.Spawn( worker, bucket_begin, bucket_end );
+     }
+  }
+//+----------------------------------------------------+
+//|                            |
+//+----------------------------------------------------+
+template<class IntType>
+void CParallelSampleSort<IntType>::ClassifierBuild( SClassifier &classifier, IntType* begin, IntType* end )
+  {
+   const size_t total = end - begin;
+   size_t log_buckets = 1;
+   while( log_buckets < MAX_LOG_BUCKETS && ( BASE_CASE << log_buckets ) < total )
+      log_buckets++;
+   const size_t buckets = size_t( 1 ) << log_buckets;
+   const size_t sample = std::min( total, OVERSAMPLING * buckets );
+//--- :        
+   uint64_t state = ( total * 0x9E3779B97F4A7C15ull ) | 1;
+   for( size_t index = 0; index < sample; index++ )
+     {
+      state ^= state << 13;
+      state ^= state >> 7;
+      state ^= state << 17;
+      std::swap( begin[index], begin[index + state % ( total - index )] );
+     }
+   SLeafSort<IntType>::Sort( begin, begin + sample );
+//---   : lower[b] -    b
+   IntType* splitters = classifier.lower + 1;
+   size_t count = 0;
+   for( size_t bucket = 1; bucket < buckets; bucket++ )
+     {
+      const IntType &splitter = begin[bucket * sample / buckets];
+      if( count == 0 || splitters[count - 1] < splitter )
+         splitters[count++] = splitter;
+     }
+//---    ,        
+   classifier.log_buckets = 1;
+   while( ( size_t( 1 ) << classifier.log_buckets ) - 1 < count )
+      classifier.log_buckets++;
+   classifier.buckets = size_t( 1 ) << classifier.log_buckets;
+   for( size_t index = count; index + 1 < classifier.buckets; index++ )
+      splitters[index] = splitters[count - 1];
+   classifier.lower[0] = splitters[0];
+   TreeBuild( classifier, 1, 0, classifier.buckets - 1 );
+  }
+//+----------------------------------------------------+
+//|                |
+//+----------------------------------------------------+
+template<class IntType>
+void CParallelSampleSort<IntType>::TreeBuild( SClassifier &classifier, const size_t node, const size_t low, const size_t high )
+  {
+   if( low >= high )
+      return;
+   const size_t middle = ( low + high ) / 2;
+   classifier.tree[node] = classifier.lower[middle + 1];
+   TreeBuild( classifier, 2 * node, low, middle );
+   TreeBuild( classifier, 2 * node + 1, middle + 1, high );
+  }
+//+----------------------------------------------------+
+//|                                     |
+//+----------------------------------------------------+
+template<class IntType>
+size_t CParallelSampleSort<IntType>::Bucket( const SClassifier &classifier, const IntType &item )
+  {
+   size_t node = 1;
+   for( size_t level = 0; level < classifier.log_buckets; level++ )
+      node = 2 * node + !( item < classifier.tree[node] );
+   return( Bucket( classifier, item, node - classifier.buckets ) );
+  }
+//+----------------------------------------------------+
+//|                     |
+//+----------------------------------------------------+
+template<class IntType>
+void CParallelSampleSort<IntType>::StripeClassify( const SClassifier &classifier, const size_t worker, IntType* begin, IntType* end )
+  {
+   SWorker &data = m_workers[worker];
+   const size_t buckets = 2 * classifier.buckets;
+   std::fill( data.fill, data.fill + buckets, 0 );
+   std::fill( data.full, data.full + buckets, 0 );
+   data.stripe_begin = begin;
+//---         ,     
+   IntType* written = begin;
+   IntType* item = begin;
+   for( ; end - item >= (ptrdiff_t) UNROLL; item += UNROLL )
+     {
+      //---     , UNROLL    
+      size_t nodes[UNROLL];
+      SAMPLE_SORT_UNROLL
+      for( size_t index = 0; index < UNROLL; index++ )
+         nodes[index] = 1;
+      for( size_t level = 0; level < classifier.log_buckets; level++ )
         {
-         QuickSortAdd();
-         CParallelSort<IntType>::IOService().post( boost::bind( &CParallelQuickSort::QuickSort, this, left, end ) );
+         SAMPLE_SORT_UNROLL
+         for( size_t index = 0; index < UNROLL; index++ )
+            nodes[index] = 2 * nodes[index] + !( item[index] < classifier.tree[nodes[index]] );
         }
+      SAMPLE_SORT_UNROLL
+      for( size_t index = 0; index < UNROLL; index++ )
+         Push( data, Bucket( classifier, item[index], nodes[index] - classifier.buckets ), item[index], written );
      }
-   QuickSortComplete();
+   for( ; item < end; item++ )
+      Push( data, Bucket( classifier, *item ), *item, written );
+   data.written = written;
   }
 //+----------------------------------------------------+
-//|                        |
+//|                                |
 //+----------------------------------------------------+
 template<class IntType>
-void CParallelQuickSort<IntType>::SortWait()
+void CParallelSampleSort<IntType>::Push( SWorker &data, const size_t bucket, const IntType &item, IntType* &written )
   {
-   boost::unique_lock<boost::mutex> lock( m_chunks_sorted_sync );
-//--- TODO:  wait  
-   while( m_chunks_sorted < m_chunks_total )
-      m_chunks_sorted_cond.wait( lock );
+   IntType* buffer = &data.blocks[bucket * BLOCK];
+   buffer[data.fill[bucket]++] = item;
+   if( data.fill[bucket] < BLOCK )
+      return;
+//---     
+   memcpy( written, buffer, BLOCK * sizeof( IntType ) );
+   written += BLOCK;
+   data.fill[bucket] = 0;
+   data.full[bucket]++;
+  }
+//+----------------------------------------------------+
+//|                      |
+//+----------------------------------------------------+
+template<class IntType>
+void CParallelSampleSort<IntType>::PhaseRun( const Phase phase, const char* name, const size_t count )
+  {
+   m_phase_completed_sync.lock();
+   m_phase_completed = 0;
+   m_phase_completed_sync.unlock();
+   for( size_t worker = 0; worker < count; worker++ )
+      CParallelSort<IntType>::IOService().post( boost::bind( &CParallelSampleSort::PhaseTask, this, phase, name, count, worker ) );
+   boost::unique_lock<boost::mutex> lock( m_phase_completed_sync );
+   while( m_phase_completed < count )
+      m_phase_completed_cond.wait( lock );
+  }
+//+----------------------------------------------------+
+//|                           |
+//+----------------------------------------------------+
+template<class IntType>
+void CParallelSampleSort<IntType>::PhaseTask( const Phase phase, const char* name, const size_t count, const size_t worker )
+  {
+     {
+      CTraceScope trace( name );
+      ( this->*phase )( 0, count, worker );
+     }
+//---     :       
+   boost::lock_guard<boost::mutex> lock( m_phase_completed_sync );
+   m_phase_completed++;
+   m_phase_completed_cond.notify_all();
+  }
+//+----------------------------------------------------+
+//|                          |
+//+----------------------------------------------------+
+template<class IntType>
+IntType* CParallelSampleSort<IntType>::StripeBegin( const SWorker &owner, const size_t stripe, const size_t count )
+  {
+   if( stripe == count )
+      return( owner.end );
+   return( owner.begin + stripe * ( size_t( owner.end - owner.begin ) / BLOCK ) / count * BLOCK );
+  }
+//+----------------------------------------------------+
+//|                      |
+//+----------------------------------------------------+
+template<class IntType>
+void CParallelSampleSort<IntType>::StripeTask( const size_t first, const size_t count, const size_t worker )
+  {
+   const SWorker &owner = m_workers[first];
+   StripeClassify( owner.classifier, worker, StripeBegin( owner, worker - first, count ), StripeBegin( owner, worker - first + 1, count ) );
+  }
+//+----------------------------------------------------+
+//|                                        |
+//+----------------------------------------------------+
+//|      ,   |
+//|   ,    ;     |
+//|          |
+//|   .      |
+//|     ,      |
+//| ,             |
+//|    .       |
+//|    32 :   2^32      |
+//+----------------------------------------------------+
+template<class IntType>
+void CParallelSampleSort<IntType>::Distribute( const size_t first, const size_t count, size_t* bounds )
+  {
+   SWorker &owner = m_workers[first];
+   const size_t buckets = 2 * owner.classifier.buckets;
+//---        
+   owner.bounds[0] = owner.slots[0] = 0;
+   for( size_t bucket = 0; bucket < buckets; bucket++ )
+     {
+      size_t size = 0;
+      for( size_t worker = first; worker < first + count; worker++ )
+         size += m_workers[worker].full[bucket] * BLOCK + m_workers[worker].fill[bucket];
+      owner.bounds[bucket + 1] = owner.bounds[bucket] + size;
+      owner.slots[bucket + 1] = ( owner.bounds[bucket + 1] + BLOCK - 1 ) / BLOCK;
+     }
+   owner.overflow = 0;
+//---     
+   if( count == 1 )
+     {
+      BucketsGather( first, 1, first );
+      Permute( first, 1, first );
+      BucketsCleanup( first, 1, first );
+     }
+   else
+     {
+      PhaseRun( &CParallelSampleSort::BucketsGather, "sample sort gather", count );
+      PhaseRun( &CParallelSampleSort::Permute, "sample sort permute", count );
+      //---           , 
+      //---    , -   
+      for( size_t worker = first; worker < first + count; worker++ )
+        {
+         size_t low, high;
+         BucketsRange( buckets, count, worker - first, low, high );
+         SWorker &data = m_workers[worker];
+         data.saved = ( low < high && owner.bounds[high] < owner.bounds[buckets] ) ? Overflow( owner, high - 1 ) : 0;
+         memcpy( &data.blocks[SAVED_BLOCK * BLOCK], owner.begin + owner.bounds[high], data.saved * sizeof( IntType ) );
+        }
+      PhaseRun( &CParallelSampleSort::BucketsCleanup, "sample sort cleanup", count );
+     }
+   memcpy( bounds, owner.bounds, ( buckets + 1 ) * sizeof( size_t ) );
+  }
+//+----------------------------------------------------+
+//|                                |
+//+----------------------------------------------------+
+template<class IntType>
+void CParallelSampleSort<IntType>::BucketsRange( const size_t buckets, const size_t count, const size_t index, size_t &low, size_t &high )
+  {
+   low = index * buckets / count;
+   high = ( index + 1 ) * buckets / count;
+  }
+//+----------------------------------------------------+
+//|                        |
+//+----------------------------------------------------+
+template<class IntType>
+bool CParallelSampleSort<IntType>::BlockFull( const size_t first, const size_t count, const size_t slot ) const
+  {
+   const IntType* block = m_workers[first].begin + slot * BLOCK;
+//---   - ,    ;      
+   size_t worker = first + count - 1;
+   while( m_workers[worker].stripe_begin > block )
+      worker--;
+   return( block + BLOCK <= m_workers[worker].written );
+  }
+//+----------------------------------------------------+
+//|                    |
+//+----------------------------------------------------+
+template<class IntType>
+void CParallelSampleSort<IntType>::BucketsGather( const size_t first, const size_t count, const size_t worker )
+  {
+   SWorker &owner = m_workers[first];
+   size_t low, high;
+   BucketsRange( 2 * owner.classifier.buckets, count, worker - first, low, high );
+   for( size_t bucket = low; bucket < high; bucket++ )
+     {
+      const size_t slot_begin = owner.slots[bucket];
+      const size_t slot_end = owner.slots[bucket + 1];
+      size_t full = 0;
+      for( size_t slot = slot_begin; slot < slot_end; slot++ )
+         full += BlockFull( first, count, slot );
+      //---     full      :    
+      size_t source = slot_end;
+      for( size_t slot = slot_begin; slot < slot_begin + full; slot++ )
+         if( !BlockFull( first, count, slot ) )
+           {
+            do
+               source--;
+            while( !BlockFull( first, count, source ) );
+            memcpy( owner.begin + slot * BLOCK, owner.begin + source * BLOCK, BLOCK * sizeof( IntType ) );
+           }
+      owner.pointers[bucket].position = ( (unsigned long long) slot_begin << 32 ) | ( slot_begin + full );
+      owner.pointers[bucket].reading = 0;
+     }
+  }
+//+----------------------------------------------------+
+//|                                  |
+//+----------------------------------------------------+
+template<class IntType>
+void CParallelSampleSort<IntType>::Permute( const size_t first, const size_t count, const size_t worker )
+  {
+   SWorker &owner = m_workers[first];
+   const size_t buckets = 2 * owner.classifier.buckets;
+   IntType* current = &m_workers[worker].blocks[SWAP_BLOCK * BLOCK];
+   IntType* swap = current + BLOCK;
+//---          ,      
+   const size_t start = ( worker - first ) * buckets / count;
+   for( size_t step = 0; step < buckets; )
+     {
+      if( !BlockRead( owner, ( start + step ) % buckets, current ) )
+        {
+         step++;
+         continue;
+        }
+      //---       ;    ,   
+      for( ;; )
+        {
+         SPointers &pointers = owner.pointers[Bucket( owner.classifier, current[0] )];
+         const unsigned long long position = pointers.position.fetch_add( 1ull << 32 );
+         const size_t slot = size_t( position >> 32 );
+         if( slot < size_t( position & 0xFFFFFFFFull ) )
+           {
+            memcpy( swap, owner.begin + slot * BLOCK, BLOCK * sizeof( IntType ) );
+            BlockWrite( owner, slot, current );
+            std::swap( current, swap );
+            continue;
+           }
+         //---   ,      
+         while( pointers.reading.load() != 0 )
+            boost::this_thread::yield();
+         BlockWrite( owner, slot, current );
+         break;
+        }
+     }
+  }
+//+----------------------------------------------------+
+//|                  |
+//+----------------------------------------------------+
+template<class IntType>
+bool CParallelSampleSort<IntType>::BlockRead( SWorker &owner, const size_t bucket, IntType* block )
+  {
+   SPointers &pointers = owner.pointers[bucket];
+   pointers.reading.fetch_add( 1 );
+   unsigned long long position = pointers.position.load();
+   for( ;; )
+     {
+      const size_t write = size_t( position >> 32 );
+      const size_t read = size_t( position & 0xFFFFFFFFull );
+      if( read <= write )
+         break;
+      if( pointers.position.compare_exchange_weak( position, position - 1 ) )
+        {
+         memcpy( block, owner.begin + ( read - 1 ) * BLOCK, BLOCK * sizeof( IntType ) );
+         pointers.reading.fetch_sub( 1 );
+         return( true );
+        }
+     }
+   pointers.reading.fetch_sub( 1 );
+   return( false );
+  }
+//+----------------------------------------------------+
+//|                               |
+//+----------------------------------------------------+
+template<class IntType>
+void CParallelSampleSort<IntType>::BlockWrite( SWorker &owner, const size_t slot, const IntType* block )
+  {
+   IntType* target = owner.begin + slot * BLOCK;
+   const size_t left = owner.end - target;
+   const size_t size = left < BLOCK ? left : BLOCK;
+   memcpy( target, block, size * sizeof( IntType ) );
+//---         ,  
+   if( size < BLOCK )
+     {
+      memcpy( &owner.blocks[OVERFLOW_BLOCK * BLOCK], block + size, ( BLOCK - size ) * sizeof( IntType ) );
+      owner.overflow = BLOCK - size;
+     }
+  }
+//+----------------------------------------------------+
+//|                                      |
+//+----------------------------------------------------+
+template<class IntType>
+size_t CParallelSampleSort<IntType>::Overflow( const SWorker &owner, const size_t bucket )
+  {
+   const size_t blocks_end = size_t( owner.pointers[bucket].position.load() >> 32 ) * BLOCK;
+//---           
+   if( blocks_end <= owner.slots[bucket] * BLOCK || blocks_end <= owner.bounds[bucket + 1] )
+      return( 0 );
+   return( blocks_end - owner.bounds[bucket + 1] );
+  }
+//+----------------------------------------------------+
+//|                 |
+//+----------------------------------------------------+
+template<class IntType>
+void CParallelSampleSort<IntType>::BucketsCleanup( const size_t first, const size_t count, const size_t worker )
+  {
+   SWorker &owner = m_workers[first];
+   const size_t buckets = 2 * owner.classifier.buckets;
+   size_t low, high;
+   BucketsRange( buckets, count, worker - first, low, high );
+//---  :     ,  
+   for( size_t bucket = low; bucket < high; bucket++ )
+     {
+      const size_t bound = owner.bounds[bucket];
+      const size_t bound_next = owner.bounds[bucket + 1];
+      const size_t blocks_begin = std::min( owner.slots[bucket] * BLOCK, bound_next );
+      const size_t blocks_end = std::min( size_t( owner.pointers[bucket].position.load() >> 32 ) * BLOCK, bound_next );
+      //---   :        
+      IntType* gaps[4] = { owner.begin + bound, owner.begin + blocks_begin, owner.begin + std::max( blocks_begin, blocks_end ), owner.begin + bound_next };
+      //---  ,    , -  ,    - ,  
+      //---  ;       
+      const IntType* overflow = owner.begin + bound_next;
+      if( overflow == owner.end )
+         overflow = &owner.blocks[OVERFLOW_BLOCK * BLOCK];
+      else
+         if( bucket + 1 == high && count > 1 )
+            overflow = &m_workers[worker].blocks[SAVED_BLOCK * BLOCK];
+      GapsCopy( gaps, overflow, Overflow( owner, bucket ) );
+      for( size_t index = first; index < first + count; index++ )
+         GapsCopy( gaps, &m_workers[index].blocks[bucket * BLOCK], m_workers[index].fill[bucket] );
+     }
+  }
+//+----------------------------------------------------+
+//|   ,            |
+//+----------------------------------------------------+
+template<class IntType>
+void CParallelSampleSort<IntType>::GapsCopy( IntType** gaps, const IntType* source, size_t count )
+  {
+   while( count > 0 )
+     {
+      if( gaps[0] == gaps[1] )
+        {
+         gaps[0] = gaps[2];
+         gaps[1] = gaps[3];
+        }
+      const size_t size = std::min<size_t>( count, gaps[1] - gaps[0] );
+      memcpy( gaps[0], source, size * sizeof( IntType ) );
+      gaps[0] += size;
+      source += size;
+      count -= size;
+     }
+  }
+//+----------------------------------------------------+
+//|   (LSD)           |
+//+----------------------------------------------------+
+template<class IntType = unsigned>
+class CParallelRadixSort : public CParallelSort<IntType>
+  {
+   //---      ,      
+   typedef typename SKeyExtractor<IntType>::KeyType KeyType;
+   typedef typename SKeyTraits<KeyType>::RadixType RadixType;
+
+private:
+   //---     
+   static const int  DIGIT_BITS = 11;
+   static const size_t BUCKETS = size_t( 1 ) << DIGIT_BITS;
+   //---     -   
+   static const size_t LINE_ITEMS = 64 / sizeof( IntType ) > 0 ? 64 / sizeof( IntType ) : 1;
+   //---   ,   
+   static const size_t BLOCK_MIN = 64 * 1024;
+   //---     
+   size_t            m_count;
+   size_t            m_blocks;
+   //---  ,    -    
+   std::vector<size_t> m_offsets;
+   //---   
+   size_t            m_blocks_completed;
+   boost::mutex      m_blocks_completed_sync;
+   boost::condition_variable m_blocks_completed_cond;
+
+public:
+                     CParallelRadixSort( boost::asio::io_service &io, const int concurrency_level );
+
+private:
+   //---  
+   virtual bool      SortImpl( IntType* begin, IntType* end, IntType* result );
+   //---     ,     result  scratch
+   virtual bool      SortConstImpl( const IntType* begin, const IntType* end, IntType* result, IntType* scratch );
+   //---   
+   static size_t     Digit( const IntType &item, const int shift ) { return( size_t( SKeyTraits<KeyType>::Radix( SKeyExtractor<IntType>::Key( item ) ) >> shift ) & ( BUCKETS - 1 ) ); }
+   //---  
+   size_t            BlockBound( const size_t block ) const { return( block * m_count / m_blocks ); }
+   //---      
+   void              BlocksRun( void ( CParallelRadixSort::*task )( size_t, const IntType*, IntType*, int ), const IntType* source, IntType* target, const int shift );
+   void              BlockComplete() { m_blocks_completed_sync.lock(); m_blocks_completed++; m_blocks_completed_sync.unlock(); m_blocks_completed_cond.notify_all(); }
+   //---    
+   void              Histogram( size_t block, const IntType* source, IntType* target, int shift );
+   //---    
+   void              Scatter( size_t block, const IntType* source, IntType* target, int shift );
+  };
+//+----------------------------------------------------+
+//|                                         |
+//+----------------------------------------------------+
+template<class IntType>
+CParallelRadixSort<IntType>::CParallelRadixSort( boost::asio::io_service &io, const int concurrency_level ) : CParallelSort<IntType>( io, concurrency_level ), m_count( 0 ), m_blocks( 1 ), m_blocks_completed( 0 )
+  {
+  }
+//+----------------------------------------------------+
+//|                                    |
+//+----------------------------------------------------+
+template<class IntType>
+bool CParallelRadixSort<IntType>::SortImpl( IntType* begin, IntType* end, IntType* result )
+  {
+   if( begin == nullptr || end == nullptr || result == nullptr || begin > end )
+      return( false );
+//---            
+   return( SortConstImpl( begin, end, result, begin ) );
+  }
+//+----------------------------------------------------+
+//|                        |
+//+----------------------------------------------------+
+template<class IntType>
+bool CParallelRadixSort<IntType>::SortConstImpl( const IntType* begin, const IntType* end, IntType* result, IntType* scratch )
+  {
+   if( begin == nullptr || end == nullptr || result == nullptr || scratch == nullptr || begin > end )
+      return( false );
+//---       ,    
+   m_count = end - begin;
+   m_blocks = std::max<size_t>( 1, std::min<size_t>( CParallelSort<IntType>::ConcurrencyLevel(), m_count / BLOCK_MIN ) );
+   m_offsets.assign( m_blocks * BUCKETS, 0 );
+//---      ,    result  scratch
+   const IntType* source = begin;
+   IntType* target = result;
+   for( int shift = 0; shift < int( sizeof( RadixType ) * 8 ); shift += DIGIT_BITS )
+     {
+      BlocksRun( &CParallelRadixSort::Histogram, source, target, shift );
+      //---     ,  -       
+      size_t offset = 0;
+      bool skip = false;
+      for( size_t bucket = 0; bucket < BUCKETS; bucket++ )
+        {
+         const size_t bucket_begin = offset;
+         for( size_t block = 0; block < m_blocks; block++ )
+           {
+            const size_t count = m_offsets[block * BUCKETS + bucket];
+            m_offsets[block * BUCKETS + bucket] = offset;
+            offset += count;
+           }
+         //---      -    
+         if( offset - bucket_begin == m_count )
+            skip = true;
+        }
+      if( skip )
+         continue;
+      BlocksRun( &CParallelRadixSort::Scatter, source, target, shift );
+      source = target;
+      target = ( target == result ) ? scratch : result;
+     }
+//---     result
+   if( source != result )
+      memcpy( result, source, m_count * sizeof( IntType ) );
+   return( true );
+  }
+//+----------------------------------------------------+
+//|                |
+//+----------------------------------------------------+
+template<class IntType>
+void CParallelRadixSort<IntType>::BlocksRun( void ( CParallelRadixSort::*task )( size_t, const IntType*, IntType*, int ), const IntType* source, IntType* target, const int shift )
+  {
+   m_blocks_completed_sync.lock();
+   m_blocks_completed = 0;
+   m_blocks_completed_sync.unlock();
+   for( size_t block = 0; block < m_blocks; block++ )
+      CParallelSort<IntType>::IOService().post( boost::bind( task, this, block, source, target, shift ) );
+   boost::unique_lock<boost::mutex> lock( m_blocks_completed_sync );
+   while( m_blocks_completed < m_blocks )
+      m_blocks_completed_cond.wait( lock );
+  }
+//+----------------------------------------------------+
+//|                              |
+//+----------------------------------------------------+
+template<class IntType>
+void CParallelRadixSort<IntType>::Histogram( size_t block, const IntType* source, IntType* target, int shift )
+  {
+   CTraceScope trace( "radix histogram" );
+   size_t* counts = &m_offsets[block * BUCKETS];
+   std::fill( counts, counts + BUCKETS, 0 );
+   for( const IntType* item = source + BlockBound( block ); item < source + BlockBound( block + 1 ); item++ )
+      counts[Digit( *item, shift )]++;
+//---   
+   BlockComplete();
+  }
+//+----------------------------------------------------+
+//|                        |
+//+----------------------------------------------------+
+template<class IntType>
+void CParallelRadixSort<IntType>::Scatter( size_t block, const IntType* source, IntType* target, int shift )
+  {
+   CTraceScope trace( "radix scatter" );
+   size_t* offsets = &m_offsets[block * BUCKETS];
+//---            ,    
+   std::unique_ptr<IntType[]> lines( new IntType[BUCKETS * LINE_ITEMS] );
+   std::vector<unsigned char> fill( BUCKETS, 0 );
+   for( const IntType* item = source + BlockBound( block ); item < source + BlockBound( block + 1 ); item++ )
+     {
+      const size_t digit = Digit( *item, shift );
+      IntType* line = &lines[digit * LINE_ITEMS];
+      line[fill[digit]++] = *item;
+      if( fill[digit] == LINE_ITEMS )
+        {
+         memcpy( target + offsets[digit], line, LINE_ITEMS * sizeof( IntType ) );
+         offsets[digit] += LINE_ITEMS;
+         fill[digit] = 0;
+        }
+     }
+//---   
+   for( size_t digit = 0; digit < BUCKETS; digit++ )
+      if( fill[digit] > 0 )
+         memcpy( target + offsets[digit], &lines[digit * LINE_ITEMS], fill[digit] * sizeof( IntType ) );
+//---   
+   BlockComplete();
   }
 //+----------------------------------------------------+
@@ -0,0 +1,143 @@
+//+----------------------------------------------------+
+//| Author: Maxim Ulyanov <ulyanov.maxim@gmail.com>    |
+//+----------------------------------------------------+
+//+----------------------------------------------------+
+//|  ,         |
+//+----------------------------------------------------+
+template<class KeyType>
+struct SKeyTraits
+  {
+   static_assert( std::is_integral<KeyType>::value && std::is_unsigned<KeyType>::value, "unsupported key type" );
+   //---      
+   typedef KeyType   RadixType;
+   static RadixType  Radix( const KeyType key ) { return( key ); }
+   static KeyType    Key( const RadixType radix ) { return( radix ); }
+  };
+//+----------------------------------------------------+
+//|  :                |
+//+----------------------------------------------------+
+template<class KeyType, class UnsignedType>
+struct SSignedKeyTraits
+  {
+   typedef UnsignedType RadixType;
+   static RadixType  Radix( const KeyType key ) { return( RadixType( key ) ^ ( RadixType( 1 ) << ( sizeof( RadixType ) * 8 - 1 ) ) ); }
+   static KeyType    Key( const RadixType radix ) { return( KeyType( radix ^ ( RadixType( 1 ) << ( sizeof( RadixType ) * 8 - 1 ) ) ) ); }
+  };
+template<> struct SKeyTraits<int32_t> : SSignedKeyTraits<int32_t, uint32_t> {};
+template<> struct SKeyTraits<int64_t> : SSignedKeyTraits<int64_t, uint64_t> {};
+//+----------------------------------------------------+
+//|  IEEE-754:       |
+//| ,   -              |
+//+----------------------------------------------------+
+template<class KeyType, class UnsignedType>
+struct SFloatKeyTraits
+  {
+   static_assert( sizeof( KeyType ) == sizeof( UnsignedType ), "float and its bits differ in size" );
+   typedef UnsignedType RadixType;
+   static RadixType  Radix( const KeyType key );
+   static KeyType    Key( const RadixType radix );
+  };
+//+----------------------------------------------------+
+//|   IEEE-754        |
+//+----------------------------------------------------+
+template<class KeyType, class UnsignedType>
+UnsignedType SFloatKeyTraits<KeyType, UnsignedType>::Radix( const KeyType key )
+  {
+   const int sign_shift = sizeof( RadixType ) * 8 - 1;
+   RadixType bits;
+   memcpy( &bits, &key, sizeof( bits ) );
+//---   :    ,    
+   const RadixType mask = RadixType( 0 - ( bits >> sign_shift ) ) | ( RadixType( 1 ) << sign_shift );
+   return( bits ^ mask );
+  }
+//+----------------------------------------------------+
+//|  IEEE-754              |
+//+----------------------------------------------------+
+template<class KeyType, class UnsignedType>
+KeyType SFloatKeyTraits<KeyType, UnsignedType>::Key( const RadixType radix )
+  {
+   const int sign_shift = sizeof( RadixType ) * 8 - 1;
+//---     :   ,    
+   const RadixType mask = RadixType( ( radix >> sign_shift ) - 1 ) | ( RadixType( 1 ) << sign_shift );
+   const RadixType bits = radix ^ mask;
+   KeyType key;
+   memcpy( &key, &bits, sizeof( key ) );
+   return( key );
+  }
+template<> struct SKeyTraits<float> : SFloatKeyTraits<float, uint32_t> {};
+template<> struct SKeyTraits<double> : SFloatKeyTraits<double, uint64_t> {};
+//+----------------------------------------------------+
+//|                 |
+//+----------------------------------------------------+
+template<class IntType>
+struct SKeyExtractor
+  {
+   //---      
+   typedef IntType   KeyType;
+   static KeyType    Key( const IntType &item ) { return( item ); }
+  };
+//+----------------------------------------------------+
+//|                                |
+//+----------------------------------------------------+
+template<class FloatType>
+struct SFloatKey
+  {
+   FloatType         value;
+   //---    :  ,  -0  NaN,    
+   bool              operator<( const SFloatKey &key ) const { return( SKeyTraits<FloatType>::Radix( value ) < SKeyTraits<FloatType>::Radix( key.value ) ); }
+   bool              operator>( const SFloatKey &key ) const { return( key < *this ); }
+  };
+//+----------------------------------------------------+
+//|                       |
+//+----------------------------------------------------+
+template<class FloatType>
+struct SKeyExtractor<SFloatKey<FloatType>>
+  {
+   typedef FloatType KeyType;
+   static KeyType    Key( const SFloatKey<FloatType> &item ) { return( item.value ); }
+  };
+//+----------------------------------------------------+
+//|               |
+//+----------------------------------------------------+
+template<size_t WIDTH, class KeyType = unsigned>
+struct SRecord
+  {
+   static_assert( WIDTH >= sizeof( KeyType ), "record is narrower than its key" );
+   //---  ;    ,   -  WIDTH 
+   unsigned char     data[WIDTH];
+   //---  ,     
+   static size_t     s_key_offset;
+   //---   :     
+   KeyType           Key() const { KeyType key; memcpy( &key, data + s_key_offset, sizeof( key ) ); return( key ); }
+   //---    
+   bool              operator<( const SRecord &record ) const { return( SKeyTraits<KeyType>::Radix( Key() ) < SKeyTraits<KeyType>::Radix( record.Key() ) ); }
+   bool              operator>( const SRecord &record ) const { return( record < *this ); }
+   //---   ,      
+   static bool       KeyOffset( const size_t offset );
+  };
+//+----------------------------------------------------+
+//|                                |
+//+----------------------------------------------------+
+template<size_t WIDTH, class KeyType>
+size_t SRecord<WIDTH, KeyType>::s_key_offset = 0;
+//+----------------------------------------------------+
+//|                              |
+//+----------------------------------------------------+
+template<size_t WIDTH, class KeyType>
+bool SRecord<WIDTH, KeyType>::KeyOffset( const size_t offset )
+  {
+   if( offset > WIDTH - sizeof( KeyType ) )
+      return( false );
+   s_key_offset = offset;
+   return( true );
+  }
+//+----------------------------------------------------+
+//|                                          |
+//+----------------------------------------------------+
+template<size_t WIDTH, class RecordKeyType>
+struct SKeyExtractor<SRecord<WIDTH, RecordKeyType>>
+  {
+   typedef RecordKeyType KeyType;
+   static KeyType    Key( const SRecord<WIDTH, RecordKeyType> &record ) { return( record.Key() ); }
+  };
+//+----------------------------------------------------+
@@ -0,0 +1,305 @@
+//+----------------------------------------------------+
+//| Author: Maxim Ulyanov <ulyanov.maxim@gmail.com>    |
+//+----------------------------------------------------+
+//+----------------------------------------------------+
+//|   :     |
+//| ,         |
+//+----------------------------------------------------+
+template<class IntType = unsigned>
+class CRunCodec
+  {
+public:
+   //---      :      
+   typedef typename SKeyExtractor<IntType>::KeyType KeyType;
+   typedef typename SKeyTraits<KeyType>::RadixType RadixType;
+   //---      ,     
+   static const bool SUPPORTED = sizeof( IntType ) == sizeof( KeyType );
+   //---    : i-  -   i % LANES,      ,
+   //---         ;   - WORD_BITS 
+   static const size_t LANES = 8;
+   static const size_t WORD_BITS = sizeof( RadixType ) * 8;
+   static const size_t BLOCK_ITEMS = LANES * WORD_BITS;
+   //---  
+   struct SHeader
+     {
+      //---   
+      RadixType      base;
+      //---     
+      unsigned       count;
+      unsigned       bits;
+     };
+
+public:
+   //---    
+   static size_t     BodySize( const SHeader &header ) { return( LANES * header.bits * sizeof( RadixType ) ); }
+   //---    
+   static bool       Valid( const SHeader &header ) { return( header.count > 0 && header.count <= BLOCK_ITEMS && header.bits <= WORD_BITS ); }
+   //---     output, offsets -  ; false,     
+   static bool       Encode( const IntType* begin, const IntType* end, char* output, const size_t output_max, size_t &output_size, std::vector<unsigned long long> &offsets );
+   //---  , body   
+   static void       Decode( const SHeader &header, const char* body, IntType* output );
+
+private:
+   //---  ,   
+   static size_t     EncodeBlock( const IntType* begin, const size_t count, char* output );
+  };
+//+----------------------------------------------------+
+//|                      |
+//+----------------------------------------------------+
+template<class IntType>
+bool CRunCodec<IntType>::Encode( const IntType* begin, const IntType* end, char* output, const size_t output_max, size_t &output_size, std::vector<unsigned long long> &offsets )
+  {
+   const size_t count = end - begin;
+   output_size = 0;
+   offsets.clear();
+   for( size_t block = 0; block < count; block += BLOCK_ITEMS )
+     {
+      //---     
+      if( output_size + sizeof( SHeader ) + LANES * WORD_BITS * sizeof( RadixType ) > output_max )
+         return( false );
+      offsets.push_back( output_size );
+      output_size += EncodeBlock( begin + block, std::min( (size_t) BLOCK_ITEMS, count - block ), output + output_size );
+     }
+   return( output_size < count * sizeof( IntType ) );
+  }
+//+----------------------------------------------------+
+//|                                         |
+//+----------------------------------------------------+
+template<class IntType>
+size_t CRunCodec<IntType>::EncodeBlock( const IntType* begin, const size_t count, char* output )
+  {
+//---       ,    - 
+   RadixType keys[BLOCK_ITEMS], deltas[BLOCK_ITEMS];
+   for( size_t index = 0; index < count; index++ )
+      keys[index] = SKeyTraits<KeyType>::Radix( SKeyExtractor<IntType>::Key( begin[index] ) );
+   RadixType used = deltas[0] = 0;
+   for( size_t index = 1; index < count; index++ )
+     {
+      deltas[index] = keys[index] - keys[index - 1];
+      used |= deltas[index];
+     }
+   std::fill( deltas + count, deltas + BLOCK_ITEMS, RadixType( 0 ) );
+//---  -   
+   SHeader header;
+   header.base = keys[0];
+   header.count = (unsigned) count;
+   header.bits = 0;
+   while( header.bits < WORD_BITS && ( used >> header.bits ) != 0 )
+      header.bits++;
+   memcpy( output, &header, sizeof( header ) );
+//---   LANES          
+   RadixType* words = (RadixType*) ( output + sizeof( header ) );
+   std::fill( words, words + LANES * header.bits, RadixType( 0 ) );
+   for( size_t row = 0; header.bits > 0 && row < WORD_BITS; row++ )
+     {
+      const size_t word = row * header.bits / WORD_BITS;
+      const size_t shift = row * header.bits % WORD_BITS;
+      const RadixType* row_deltas = deltas + row * LANES;
+      RadixType* row_words = words + word * LANES;
+      for( size_t lane = 0; lane < LANES; lane++ )
+         row_words[lane] |= row_deltas[lane] << shift;
+      //---     ,   -  
+      if( shift + header.bits > WORD_BITS )
+         for( size_t lane = 0; lane < LANES; lane++ )
+            row_words[LANES + lane] |= row_deltas[lane] >> ( WORD_BITS - shift );
+     }
+   return( sizeof( header ) + BodySize( header ) );
+  }
+//+----------------------------------------------------+
+//|                                     |
+//+----------------------------------------------------+
+template<class IntType>
+void CRunCodec<IntType>::Decode( const SHeader &header, const char* body, IntType* output )
+  {
+   RadixType deltas[BLOCK_ITEMS];
+   const RadixType mask = header.bits < WORD_BITS ? ( RadixType( 1 ) << header.bits ) - 1 : RadixType( ~RadixType( 0 ) );
+   const RadixType* words = (const RadixType*) body;
+   if( header.bits == 0 )
+      std::fill( deltas, deltas + BLOCK_ITEMS, RadixType( 0 ) );
+   for( size_t row = 0; header.bits > 0 && row < WORD_BITS; row++ )
+     {
+      const size_t word = row * header.bits / WORD_BITS;
+      const size_t shift = row * header.bits % WORD_BITS;
+      const RadixType* row_words = words + word * LANES;
+      RadixType* row_deltas = deltas + row * LANES;
+      for( size_t lane = 0; lane < LANES; lane++ )
+         row_deltas[lane] = ( row_words[lane] >> shift ) & mask;
+      if( shift + header.bits > WORD_BITS )
+         for( size_t lane = 0; lane < LANES; lane++ )
+            row_deltas[lane] |= ( row_words[LANES + lane] << ( WORD_BITS - shift ) ) & mask;
+     }
+//---     
+   RadixType key = header.base;
+   for( size_t index = 0; index < header.count; index++ )
+     {
+      key += deltas[index];
+      const KeyType item = SKeyTraits<KeyType>::Key( key );
+      memcpy( output + index, &item, sizeof( item ) );
+     }
+  }
+//+----------------------------------------------------+
+//|      ,    |
+//|                                              |
+//+----------------------------------------------------+
+template<class IntType = unsigned>
+class CRunFile
+  {
+private:
+   typedef CRunCodec<IntType> Codec;
+   //---       :  ,   
+   CBinFile          m_file;
+   CBinFile          m_index;
+   bool              m_compressed;
+   unsigned long long m_file_size;
+   size_t            m_count;
+   size_t            m_blocks;
+   //---   :      
+   std::vector<IntType> m_block;
+   size_t            m_block_index;
+   std::vector<typename Codec::RadixType> m_body;
+
+public:
+                     CRunFile() : m_compressed( false ), m_file_size( 0 ), m_count( 0 ), m_blocks( 0 ), m_block_index( std::numeric_limits<size_t>::max() ) {}
+   //---  ,      
+   bool              Open( const std::string &file_name );
+   //--- 
+   bool              Compressed() const { return( m_compressed ); }
+   size_t            Count() const { return( m_count ); }
+   //---    
+   bool              Item( const size_t index, IntType &item );
+   //---     [begin, end)        begin
+   bool              Range( const size_t begin, const size_t end, size_t &offset, size_t &length, size_t &skip );
+   //---   ,        
+   static std::string IndexName( const std::string &file_name ) { return( file_name + ".idx" ); }
+   static bool       IndexWrite( const std::string &file_name, const size_t count, const std::vector<unsigned long long> &offsets );
+   static void       Remove( const std::string &file_name );
+
+private:
+   //---  ,     -  
+   bool              BlockOffset( const size_t block, unsigned long long &offset );
+  };
+//+----------------------------------------------------+
+//|                                       |
+//+----------------------------------------------------+
+template<class IntType>
+bool CRunFile<IntType>::Open( const std::string &file_name )
+  {
+   boost::system::error_code error;
+   m_file_size = boost::filesystem::file_size( file_name, error );
+   if( error || !m_file.Open( file_name, CBinFile::MODE_READ ) )
+      return( false );
+   m_block_index = std::numeric_limits<size_t>::max();
+//---     
+   m_compressed = boost::filesystem::exists( IndexName( file_name ), error );
+   if( !m_compressed )
+     {
+      m_count = (size_t) ( m_file_size / sizeof( IntType ) );
+      return( m_file_size % sizeof( IntType ) == 0 );
+     }
+   const unsigned long long index_size = boost::filesystem::file_size( IndexName( file_name ), error );
+   unsigned long long count = 0;
+   if( error || index_size < sizeof( count ) || !m_index.Open( IndexName( file_name ), CBinFile::MODE_READ ) || m_index.Read( (char*) &count, sizeof( count ) ) != sizeof( count ) )
+      return( false );
+   m_count = (size_t) count;
+   m_blocks = (size_t) ( ( index_size - sizeof( count ) ) / sizeof( unsigned long long ) );
+   return( m_blocks == ( m_count + Codec::BLOCK_ITEMS - 1 ) / Codec::BLOCK_ITEMS );
+  }
+//+----------------------------------------------------+
+//|                             |
+//+----------------------------------------------------+
+template<class IntType>
+bool CRunFile<IntType>::Item( const size_t index, IntType &item )
+  {
+   if( index >= m_count )
+      return( false );
+   if( !m_compressed )
+     {
+      if( !m_file.Seek( (long long) index * sizeof( IntType ) ) )
+         return( false );
+      return( m_file.Read( (char*) &item, sizeof( IntType ) ) == sizeof( IntType ) );
+     }
+//---   ,     
+   const size_t block = index / Codec::BLOCK_ITEMS;
+   if( block != m_block_index )
+     {
+      unsigned long long offset = 0;
+      typename Codec::SHeader header;
+      if( !BlockOffset( block, offset ) || !m_file.Seek( (long long) offset ) || m_file.Read( (char*) &header, sizeof( header ) ) != sizeof( header ) || !Codec::Valid( header ) )
+         return( false );
+      m_body.resize( Codec::BodySize( header ) / sizeof( typename Codec::RadixType ) );
+      if( m_file.Read( (char*) m_body.data(), Codec::BodySize( header ) ) != Codec::BodySize( header ) )
+         return( false );
+      m_block.resize( Codec::BLOCK_ITEMS );
+      Codec::Decode( header, (const char*) m_body.data(), m_block.data() );
+      m_block_index = block;
+     }
+   item = m_block[index % Codec::BLOCK_ITEMS];
+   return( true );
+  }
+//+----------------------------------------------------+
+//|                    |
+//+----------------------------------------------------+
+template<class IntType>
+bool CRunFile<IntType>::Range( const size_t begin, const size_t end, size_t &offset, size_t &length, size_t &skip )
+  {
+   if( begin > end || end > m_count )
+      return( false );
+   if( !m_compressed )
+     {
+      offset = begin * sizeof( IntType );
+      length = ( end - begin ) * sizeof( IntType );
+      skip = 0;
+      return( true );
+     }
+//---     
+   const size_t first = begin / Codec::BLOCK_ITEMS;
+   const size_t last = ( end + Codec::BLOCK_ITEMS - 1 ) / Codec::BLOCK_ITEMS;
+   unsigned long long first_offset = 0, last_offset = 0;
+   if( !BlockOffset( first, first_offset ) || !BlockOffset( last, last_offset ) || first_offset > last_offset )
+      return( false );
+   offset = (size_t) first_offset;
+   length = (size_t) ( last_offset - first_offset );
+   skip = begin - first * Codec::BLOCK_ITEMS;
+   return( true );
+  }
+//+----------------------------------------------------+
+//|                                       |
+//+----------------------------------------------------+
+template<class IntType>
+bool CRunFile<IntType>::BlockOffset( const size_t block, unsigned long long &offset )
+  {
+   if( block >= m_blocks )
+     {
+      offset = m_file_size;
+      return( block == m_blocks );
+     }
+   if( !m_index.Seek( (long long) ( ( block + 1 ) * sizeof( offset ) ) ) )
+      return( false );
+   return( m_index.Read( (char*) &offset, sizeof( offset ) ) == sizeof( offset ) );
+  }
+//+----------------------------------------------------+
+//|                           |
+//+----------------------------------------------------+
+template<class IntType>
+bool CRunFile<IntType>::IndexWrite( const std::string &file_name, const size_t count, const std::vector<unsigned long long> &offsets )
+  {
+   CBinFile index;
+   const unsigned long long items = count;
+   const size_t offsets_size = offsets.size() * sizeof( unsigned long long );
+   if( index.Open( IndexName( file_name ), CBinFile::MODE_WRITE ) && index.Write( (const char*) &items, sizeof( items ) ) == sizeof( items ) && ( offsets_size == 0 || index.Write( (const char*) offsets.data(), offsets_size ) == offsets_size ) )
+      return( true );
+//---      
+   index.Close();
+   remove( IndexName( file_name ).c_str() );
+   return( false );
+  }
+//+----------------------------------------------------+
+//|                        |
+//+----------------------------------------------------+
+template<class IntType>
+void CRunFile<IntType>::Remove( const std::string &file_name )
+  {
+   remove( file_name.c_str() );
+   remove( IndexName( file_name ).c_str() );
+  }
+//+----------------------------------------------------+
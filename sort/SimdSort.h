@@ -0,0 +1,640 @@
+//+----------------------------------------------------+
+//| Author: Maxim Ulyanov <ulyanov.maxim@gmail.com>    |
+//+----------------------------------------------------+
+//---     x86    target,     
+#if defined( __GNUC__ ) && ( defined( __x86_64__ ) || defined( __i386__ ) )
+#define SIMD_SORT_X86
+#define TARGET_AVX2   __attribute__(( target( "avx2,popcnt" ) ))
+#define TARGET_AVX512 __attribute__(( target( "avx512f,popcnt" ) ))
+#endif
+//+----------------------------------------------------+
+//|   32-    |
+//+----------------------------------------------------+
+//|     ,    |
+//|          |
+//|     ;   |
+//|           |
+//+----------------------------------------------------+
+class CSimdSort
+  {
+public:
+   //---  
+   enum EnSimdLevel
+     {
+      SIMD_SCALAR,
+      SIMD_AVX2,
+      SIMD_AVX512
+     };
+
+public:
+   //---     
+   static void       Sort( uint32_t* begin, uint32_t* end ) { Sort( begin, end, Level() ); }
+   static void       Sort( uint32_t* begin, uint32_t* end, const EnSimdLevel level );
+   //---      result, result    
+   static void       Merge( const uint32_t* a, const uint32_t* a_end, const uint32_t* b, const uint32_t* b_end, uint32_t* result ) { Merge( a, a_end, b, b_end, result, Level() ); }
+   static void       Merge( const uint32_t* a, const uint32_t* a_end, const uint32_t* b, const uint32_t* b_end, uint32_t* result, const EnSimdLevel level );
+   //---   ,   
+   static EnSimdLevel Level();
+   static const char* LevelName( const EnSimdLevel level );
+
+private:
+   //---  ,    ; Kernel -     
+   template<class Kernel>
+   static void       QuickSort( uint32_t* begin, uint32_t* end, int depth );
+   //---    
+   static uint32_t   Pivot( const uint32_t* begin, const uint32_t* end );
+#ifdef SIMD_SORT_X86
+   //---  AVX-512: 16   
+   struct SAvx512
+     {
+      static const ptrdiff_t LANES = 16;
+      static const ptrdiff_t SMALL = 4 * LANES;
+      TARGET_AVX512 static uint32_t* Partition( uint32_t* begin, uint32_t* end, const uint32_t pivot );
+      TARGET_AVX512 static void PartitionStore( const __m512i v, const __m512i pivot, uint32_t* &left_store, uint32_t* &right_store );
+      TARGET_AVX512 static void SortSmall( uint32_t* begin, uint32_t* end );
+      TARGET_AVX512 static __m512i Exchange( const __m512i v, const int distance, const __mmask16 max_lanes );
+      TARGET_AVX512 static __m512i SortVector( __m512i v );
+      TARGET_AVX512 static __m512i MergeVector( __m512i v );
+      TARGET_AVX512 static __m512i Reverse( const __m512i v );
+      TARGET_AVX512 static __m512i Min( const __m512i a, const __m512i b );
+      TARGET_AVX512 static __m512i Max( const __m512i a, const __m512i b );
+      TARGET_AVX512 static void MergePair( __m512i &a, __m512i &b );
+      TARGET_AVX512 static void Merge( const uint32_t* a, const uint32_t* a_end, const uint32_t* b, const uint32_t* b_end, uint32_t* result );
+      TARGET_AVX512 static __m512i MergeLoad( const uint32_t* &begin, const uint32_t* end );
+      TARGET_AVX512 static void MergeStore( uint32_t* &result, ptrdiff_t &rest, const __m512i v );
+     };
+   //---  AVX2: 8   
+   struct SAvx2
+     {
+      static const ptrdiff_t LANES = 8;
+      static const ptrdiff_t SMALL = 4 * LANES;
+      TARGET_AVX2 static uint32_t* Partition( uint32_t* begin, uint32_t* end, const uint32_t pivot );
+      TARGET_AVX2 static void PartitionStore( const __m256i v, const __m256i pivot, const int* table, uint32_t* &left_store, uint32_t* &right_store );
+      TARGET_AVX2 static void SortSmall( uint32_t* begin, uint32_t* end );
+      template<int MAX_LANES>
+      TARGET_AVX2 static __m256i Exchange( const __m256i v, const int distance );
+      TARGET_AVX2 static __m256i SortVector( __m256i v );
+      TARGET_AVX2 static __m256i MergeVector( __m256i v );
+      TARGET_AVX2 static __m256i Reverse( const __m256i v );
+      TARGET_AVX2 static void MergePair( __m256i &a, __m256i &b );
+      TARGET_AVX2 static void Merge( const uint32_t* a, const uint32_t* a_end, const uint32_t* b, const uint32_t* b_end, uint32_t* result );
+      TARGET_AVX2 static __m256i MergeLoad( const uint32_t* &begin, const uint32_t* end );
+      TARGET_AVX2 static void MergeStore( uint32_t* &result, ptrdiff_t &rest, const __m256i v );
+      //--- ,       ,      
+      static const int* PartitionTable();
+     };
+#endif
+  };
+//+----------------------------------------------------+
+//|                     |
+//+----------------------------------------------------+
+void CSimdSort::Sort( uint32_t* begin, uint32_t* end, const EnSimdLevel level )
+  {
+   if( begin == nullptr || end == nullptr || end - begin < 2 )
+      return;
+//--- ,      std::sort
+   int depth = 0;
+   for( size_t count = end - begin; count > 1; count >>= 1 )
+      depth += 2;
+   switch( level )
+     {
+#ifdef SIMD_SORT_X86
+      case SIMD_AVX512:
+         QuickSort<SAvx512>( begin, end, depth );
+         break;
+      case SIMD_AVX2:
+         QuickSort<SAvx2>( begin, end, depth );
+         break;
+#endif
+      default:
+         std::sort( begin, end );
+         break;
+     }
+  }
+//+----------------------------------------------------+
+//|                        |
+//+----------------------------------------------------+
+void CSimdSort::Merge( const uint32_t* a, const uint32_t* a_end, const uint32_t* b, const uint32_t* b_end, uint32_t* result, const EnSimdLevel level )
+  {
+//---    
+   if( a == a_end || b == b_end )
+     {
+      if( a != a_end )
+         memcpy( result, a, ( a_end - a ) * sizeof( uint32_t ) );
+      if( b != b_end )
+         memcpy( result, b, ( b_end - b ) * sizeof( uint32_t ) );
+      return;
+     }
+   switch( level )
+     {
+#ifdef SIMD_SORT_X86
+      case SIMD_AVX512:
+         SAvx512::Merge( a, a_end, b, b_end, result );
+         break;
+      case SIMD_AVX2:
+         SAvx2::Merge( a, a_end, b, b_end, result );
+         break;
+#endif
+      default:
+         std::merge( a, a_end, b, b_end, result );
+         break;
+     }
+  }
+//+----------------------------------------------------+
+//|                               |
+//+----------------------------------------------------+
+CSimdSort::EnSimdLevel CSimdSort::Level()
+  {
+#ifdef SIMD_SORT_X86
+   static const EnSimdLevel level = __builtin_cpu_supports( "avx512f" ) ? SIMD_AVX512 : __builtin_cpu_supports( "avx2" ) ? SIMD_AVX2 : SIMD_SCALAR;
+   return( level );
+#else
+   return( SIMD_SCALAR );
+#endif
+  }
+//+----------------------------------------------------+
+//|                                     |
+//+----------------------------------------------------+
+const char* CSimdSort::LevelName( const EnSimdLevel level )
+  {
+   switch( level )
+     {
+      case SIMD_AVX512:
+         return( "avx512" );
+      case SIMD_AVX2:
+         return( "avx2" );
+      default:
+         return( "scalar" );
+     }
+  }
+//+----------------------------------------------------+
+//|                                   |
+//+----------------------------------------------------+
+template<class Kernel>
+void CSimdSort::QuickSort( uint32_t* begin, uint32_t* end, int depth )
+  {
+   while( end - begin > Kernel::SMALL )
+     {
+      if( depth-- == 0 )
+        {
+         std::sort( begin, end );
+         return;
+        }
+      const uint32_t pivot = Pivot( begin, end );
+      uint32_t* middle = Kernel::Partition( begin, end, pivot );
+      //---  -  :    ,     
+      if( middle == begin )
+        {
+         if( pivot == std::numeric_limits<uint32_t>::max() )
+            return;
+         begin = Kernel::Partition( begin, end, pivot + 1 );
+         continue;
+        }
+      //---    ,   -    
+      if( middle - begin < end - middle )
+        {
+         QuickSort<Kernel>( begin, middle, depth );
+         begin = middle;
+        }
+      else
+        {
+         QuickSort<Kernel>( middle, end, depth );
+         end = middle;
+        }
+     }
+   Kernel::SortSmall( begin, end );
+  }
+//+----------------------------------------------------+
+//|                                |
+//+----------------------------------------------------+
+uint32_t CSimdSort::Pivot( const uint32_t* begin, const uint32_t* end )
+  {
+   const ptrdiff_t count = end - begin;
+   const uint32_t a = begin[count / 4], b = begin[count / 2], c = begin[count - count / 4 - 1];
+   return( std::max( std::min( a, b ), std::min( std::max( a, b ), c ) ) );
+  }
+#ifdef SIMD_SORT_X86
+//+----------------------------------------------------+
+//| AVX-512:                   |
+//+----------------------------------------------------+
+//|  - :    ,  |
+//|  -  .        |
+//| ,    ,      |
+//|  ,               |
+//|                                       |
+//+----------------------------------------------------+
+uint32_t* CSimdSort::SAvx512::Partition( uint32_t* begin, uint32_t* end, const uint32_t pivot )
+  {
+//---        
+   for( ptrdiff_t rest = ( end - begin ) % LANES; rest > 0; rest-- )
+      if( *begin >= pivot )
+         std::swap( *begin, *--end );
+      else
+         begin++;
+   if( end - begin < 2 * LANES )
+      return( std::partition( begin, end, [pivot]( const uint32_t key ) { return( key < pivot ); } ) );
+   const __m512i pivot_v = _mm512_set1_epi32( (int) pivot );
+   const __m512i first = _mm512_loadu_si512( begin );
+   const __m512i last = _mm512_loadu_si512( end - LANES );
+   uint32_t* left = begin + LANES;
+   uint32_t* right = end - LANES;
+   uint32_t* left_store = begin;
+   uint32_t* right_store = end;
+   while( left != right )
+      if( right_store - right < left - left_store )
+        {
+         right -= LANES;
+         PartitionStore( _mm512_loadu_si512( right ), pivot_v, left_store, right_store );
+        }
+      else
+        {
+         PartitionStore( _mm512_loadu_si512( left ), pivot_v, left_store, right_store );
+         left += LANES;
+        }
+//---    ,     
+   PartitionStore( first, pivot_v, left_store, right_store );
+   PartitionStore( last, pivot_v, left_store, right_store );
+   return( left_store );
+  }
+//+----------------------------------------------------+
+//| AVX-512:            |
+//+----------------------------------------------------+
+void CSimdSort::SAvx512::PartitionStore( const __m512i v, const __m512i pivot, uint32_t* &left_store, uint32_t* &right_store )
+  {
+//---    ,  - 
+   const __mmask16 upper = _mm512_cmpge_epu32_mask( v, pivot );
+   const int upper_count = __builtin_popcount( upper );
+   _mm512_mask_compressstoreu_epi32( left_store, (__mmask16) ~upper, v );
+   left_store += LANES - upper_count;
+   right_store -= upper_count;
+   _mm512_mask_compressstoreu_epi32( right_store, upper, v );
+  }
+//+----------------------------------------------------+
+//| AVX-512:           |
+//+----------------------------------------------------+
+void CSimdSort::SAvx512::SortSmall( uint32_t* begin, uint32_t* end )
+  {
+   const ptrdiff_t count = end - begin;
+   if( count < 2 )
+      return;
+//---    ,    
+   const __m512i padding = _mm512_set1_epi32( -1 );
+   __m512i v[4];
+   __mmask16 mask[4];
+   for( int index = 0; index < 4; index++ )
+     {
+      const ptrdiff_t rest = count - index * LANES;
+      const ptrdiff_t lanes = rest <= 0 ? 0 : rest < LANES ? rest : LANES;
+      mask[index] = (__mmask16) ( ( 1u << lanes ) - 1 );
+      v[index] = SortVector( _mm512_mask_loadu_epi32( padding, mask[index], begin + index * LANES ) );
+     }
+//---   ,   
+   MergePair( v[0], v[1] );
+   MergePair( v[2], v[3] );
+   const __m512i high0 = Reverse( v[3] );
+   const __m512i high1 = Reverse( v[2] );
+   __m512i low0 = Min( v[0], high0 );
+   __m512i low1 = Min( v[1], high1 );
+   __m512i top0 = Max( v[0], high0 );
+   __m512i top1 = Max( v[1], high1 );
+   v[0] = MergeVector( Min( low0, low1 ) );
+   v[1] = MergeVector( Max( low0, low1 ) );
+   v[2] = MergeVector( Min( top0, top1 ) );
+   v[3] = MergeVector( Max( top0, top1 ) );
+   for( int index = 0; index < 4; index++ )
+      _mm512_mask_storeu_epi32( begin + index * LANES, mask[index], v[index] );
+  }
+//+----------------------------------------------------+
+//| AVX-512: -         |
+//| distance, max_lanes           |
+//+----------------------------------------------------+
+__m512i CSimdSort::SAvx512::Exchange( const __m512i v, const int distance, const __mmask16 max_lanes )
+  {
+   const __m512i partner = _mm512_xor_si512( _mm512_set_epi32( 15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0 ), _mm512_set1_epi32( distance ) );
+   const __m512i w = _mm512_maskz_permutexvar_epi32( 0xffff, partner, v );
+   return( _mm512_mask_max_epu32( _mm512_mask_min_epu32( v, (__mmask16) ~max_lanes, v, w ), max_lanes, v, w ) );
+  }
+//+----------------------------------------------------+
+//| AVX-512:                  |
+//+----------------------------------------------------+
+__m512i CSimdSort::SAvx512::SortVector( __m512i v )
+  {
+   v = Exchange( v, 1, 0x6666 );
+   v = Exchange( v, 2, 0x3c3c );
+   v = Exchange( v, 1, 0x5a5a );
+   v = Exchange( v, 4, 0x0ff0 );
+   v = Exchange( v, 2, 0x33cc );
+   v = Exchange( v, 1, 0x55aa );
+   return( MergeVector( v ) );
+  }
+//+----------------------------------------------------+
+//| AVX-512:                     |
+//+----------------------------------------------------+
+__m512i CSimdSort::SAvx512::MergeVector( __m512i v )
+  {
+   v = Exchange( v, 8, 0xff00 );
+   v = Exchange( v, 4, 0xf0f0 );
+   v = Exchange( v, 2, 0xcccc );
+   return( Exchange( v, 1, 0xaaaa ) );
+  }
+//+----------------------------------------------------+
+//| AVX-512:                      |
+//+----------------------------------------------------+
+__m512i CSimdSort::SAvx512::Reverse( const __m512i v )
+  {
+   return( _mm512_maskz_permutexvar_epi32( 0xffff, _mm512_set_epi32( 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15 ), v ) );
+  }
+//+----------------------------------------------------+
+//| AVX-512:                        |
+//+----------------------------------------------------+
+//|   -   ,          |
+//|   -Wuninitialized GCC 12       |
+//+----------------------------------------------------+
+__m512i CSimdSort::SAvx512::Min( const __m512i a, const __m512i b )
+  {
+   return( _mm512_mask_min_epu32( a, 0xffff, a, b ) );
+  }
+//+----------------------------------------------------+
+//| AVX-512:                       |
+//+----------------------------------------------------+
+__m512i CSimdSort::SAvx512::Max( const __m512i a, const __m512i b )
+  {
+   return( _mm512_mask_max_epu32( a, 0xffff, a, b ) );
+  }
+//+----------------------------------------------------+
+//| AVX-512:         |
+//+----------------------------------------------------+
+void CSimdSort::SAvx512::MergePair( __m512i &a, __m512i &b )
+  {
+   const __m512i reversed = Reverse( b );
+   const __m512i low = Min( a, reversed );
+   b = MergeVector( Max( a, reversed ) );
+   a = MergeVector( low );
+  }
+//+----------------------------------------------------+
+//| AVX-512:             |
+//+----------------------------------------------------+
+//|             |
+//| ,      , |
+//|    :         |
+//|       .      |
+//|     ,    |
+//|               |
+//+----------------------------------------------------+
+void CSimdSort::SAvx512::Merge( const uint32_t* a, const uint32_t* a_end, const uint32_t* b, const uint32_t* b_end, uint32_t* result )
+  {
+   ptrdiff_t rest = ( a_end - a ) + ( b_end - b );
+   __m512i high = MergeLoad( a, a_end );
+   __m512i low = MergeLoad( b, b_end );
+   for( ;; )
+     {
+      MergePair( low, high );
+      MergeStore( result, rest, low );
+      if( a == a_end && b == b_end )
+         break;
+      if( b == b_end || ( a != a_end && *a < *b ) )
+         low = MergeLoad( a, a_end );
+      else
+         low = MergeLoad( b, b_end );
+     }
+   MergeStore( result, rest, high );
+  }
+//+----------------------------------------------------+
+//| AVX-512:                      |
+//+----------------------------------------------------+
+__m512i CSimdSort::SAvx512::MergeLoad( const uint32_t* &begin, const uint32_t* end )
+  {
+   const ptrdiff_t lanes = std::min( end - begin, LANES );
+   const __m512i v = _mm512_mask_loadu_epi32( _mm512_set1_epi32( -1 ), (__mmask16) ( ( 1u << lanes ) - 1 ), begin );
+   begin += lanes;
+   return( v );
+  }
+//+----------------------------------------------------+
+//| AVX-512:                 |
+//+----------------------------------------------------+
+void CSimdSort::SAvx512::MergeStore( uint32_t* &result, ptrdiff_t &rest, const __m512i v )
+  {
+   const ptrdiff_t lanes = std::min( rest, LANES );
+   _mm512_mask_storeu_epi32( result, (__mmask16) ( ( 1u << lanes ) - 1 ), v );
+   result += lanes;
+   rest -= lanes;
+  }
+//+----------------------------------------------------+
+//| AVX2:                      |
+//+----------------------------------------------------+
+//|   AVX-512,    :       |
+//|   ,           |
+//|                               |
+//+----------------------------------------------------+
+uint32_t* CSimdSort::SAvx2::Partition( uint32_t* begin, uint32_t* end, const uint32_t pivot )
+  {
+   for( ptrdiff_t rest = ( end - begin ) % LANES; rest > 0; rest-- )
+      if( *begin >= pivot )
+         std::swap( *begin, *--end );
+      else
+         begin++;
+   if( end - begin < 2 * LANES )
+      return( std::partition( begin, end, [pivot]( const uint32_t key ) { return( key < pivot ); } ) );
+   const int* table = PartitionTable();
+   const __m256i pivot_v = _mm256_set1_epi32( (int) pivot );
+   const __m256i first = _mm256_loadu_si256( (const __m256i*) begin );
+   const __m256i last = _mm256_loadu_si256( (const __m256i*) ( end - LANES ) );
+   uint32_t* left = begin + LANES;
+   uint32_t* right = end - LANES;
+   uint32_t* left_store = begin;
+   uint32_t* right_store = end;
+   while( left != right )
+      if( right_store - right < left - left_store )
+        {
+         right -= LANES;
+         PartitionStore( _mm256_loadu_si256( (const __m256i*) right ), pivot_v, table, left_store, right_store );
+        }
+      else
+        {
+         PartitionStore( _mm256_loadu_si256( (const __m256i*) left ), pivot_v, table, left_store, right_store );
+         left += LANES;
+        }
+   PartitionStore( first, pivot_v, table, left_store, right_store );
+   PartitionStore( last, pivot_v, table, left_store, right_store );
+   return( left_store );
+  }
+//+----------------------------------------------------+
+//| AVX2:               |
+//+----------------------------------------------------+
+void CSimdSort::SAvx2::PartitionStore( const __m256i v, const __m256i pivot, const int* table, uint32_t* &left_store, uint32_t* &right_store )
+  {
+   const int upper = _mm256_movemask_ps( _mm256_castsi256_ps( _mm256_cmpeq_epi32( _mm256_max_epu32( v, pivot ), v ) ) );
+   const int upper_count = __builtin_popcount( upper );
+//---        ,    
+   const __m256i ordered = _mm256_permutevar8x32_epi32( v, _mm256_loadu_si256( (const __m256i*) ( table + upper * LANES ) ) );
+   _mm256_storeu_si256( (__m256i*) left_store, ordered );
+   _mm256_storeu_si256( (__m256i*) ( right_store - LANES ), ordered );
+   left_store += LANES - upper_count;
+   right_store -= upper_count;
+  }
+//+----------------------------------------------------+
+//| AVX2:              |
+//+----------------------------------------------------+
+void CSimdSort::SAvx2::SortSmall( uint32_t* begin, uint32_t* end )
+  {
+   const ptrdiff_t count = end - begin;
+   if( count < 2 )
+      return;
+   const __m256i padding = _mm256_set1_epi32( -1 );
+   const __m256i lane = _mm256_set_epi32( 7, 6, 5, 4, 3, 2, 1, 0 );
+   __m256i v[4];
+   __m256i mask[4];
+   for( int index = 0; index < 4; index++ )
+     {
+      mask[index] = _mm256_cmpgt_epi32( _mm256_set1_epi32( (int) ( count - index * LANES ) ), lane );
+      const __m256i loaded = _mm256_maskload_epi32( (const int*) ( begin + index * LANES ), mask[index] );
+      v[index] = SortVector( _mm256_blendv_epi8( padding, loaded, mask[index] ) );
+     }
+   MergePair( v[0], v[1] );
+   MergePair( v[2], v[3] );
+   const __m256i high0 = Reverse( v[3] );
+   const __m256i high1 = Reverse( v[2] );
+   __m256i low0 = _mm256_min_epu32( v[0], high0 );
+   __m256i low1 = _mm256_min_epu32( v[1], high1 );
+   __m256i top0 = _mm256_max_epu32( v[0], high0 );
+   __m256i top1 = _mm256_max_epu32( v[1], high1 );
+   v[0] = MergeVector( _mm256_min_epu32( low0, low1 ) );
+   v[1] = MergeVector( _mm256_max_epu32( low0, low1 ) );
+   v[2] = MergeVector( _mm256_min_epu32( top0, top1 ) );
+   v[3] = MergeVector( _mm256_max_epu32( top0, top1 ) );
+   for( int index = 0; index < 4; index++ )
+      _mm256_maskstore_epi32( (int*) ( begin + index * LANES ), mask[index], v[index] );
+  }
+//+----------------------------------------------------+
+//| AVX2: -            |
+//| distance,  MAX_LANES      |
+//+----------------------------------------------------+
+template<int MAX_LANES>
+__m256i CSimdSort::SAvx2::Exchange( const __m256i v, const int distance )
+  {
+   const __m256i partner = _mm256_xor_si256( _mm256_set_epi32( 7, 6, 5, 4, 3, 2, 1, 0 ), _mm256_set1_epi32( distance ) );
+   const __m256i w = _mm256_permutevar8x32_epi32( v, partner );
+   return( _mm256_blend_epi32( _mm256_min_epu32( v, w ), _mm256_max_epu32( v, w ), MAX_LANES ) );
+  }
+//+----------------------------------------------------+
+//| AVX2:                     |
+//+----------------------------------------------------+
+__m256i CSimdSort::SAvx2::SortVector( __m256i v )
+  {
+   v = Exchange<0x66>( v, 1 );
+   v = Exchange<0x3c>( v, 2 );
+   v = Exchange<0x5a>( v, 1 );
+   return( MergeVector( v ) );
+  }
+//+----------------------------------------------------+
+//| AVX2:                        |
+//+----------------------------------------------------+
+__m256i CSimdSort::SAvx2::MergeVector( __m256i v )
+  {
+   v = Exchange<0xf0>( v, 4 );
+   v = Exchange<0xcc>( v, 2 );
+   return( Exchange<0xaa>( v, 1 ) );
+  }
+//+----------------------------------------------------+
+//| AVX2:                         |
+//+----------------------------------------------------+
+__m256i CSimdSort::SAvx2::Reverse( const __m256i v )
+  {
+   return( _mm256_permutevar8x32_epi32( v, _mm256_set_epi32( 0, 1, 2, 3, 4, 5, 6, 7 ) ) );
+  }
+//+----------------------------------------------------+
+//| AVX2:            |
+//+----------------------------------------------------+
+void CSimdSort::SAvx2::MergePair( __m256i &a, __m256i &b )
+  {
+   const __m256i reversed = Reverse( b );
+   const __m256i low = _mm256_min_epu32( a, reversed );
+   b = MergeVector( _mm256_max_epu32( a, reversed ) );
+   a = MergeVector( low );
+  }
+//+----------------------------------------------------+
+//| AVX2:                |
+//+----------------------------------------------------+
+void CSimdSort::SAvx2::Merge( const uint32_t* a, const uint32_t* a_end, const uint32_t* b, const uint32_t* b_end, uint32_t* result )
+  {
+   ptrdiff_t rest = ( a_end - a ) + ( b_end - b );
+   __m256i high = MergeLoad( a, a_end );
+   __m256i low = MergeLoad( b, b_end );
+   for( ;; )
+     {
+      MergePair( low, high );
+      MergeStore( result, rest, low );
+      if( a == a_end && b == b_end )
+         break;
+      if( b == b_end || ( a != a_end && *a < *b ) )
+         low = MergeLoad( a, a_end );
+      else
+         low = MergeLoad( b, b_end );
+     }
+   MergeStore( result, rest, high );
+  }
+//+----------------------------------------------------+
+//| AVX2:                         |
+//+----------------------------------------------------+
+__m256i CSimdSort::SAvx2::MergeLoad( const uint32_t* &begin, const uint32_t* end )
+  {
+   const ptrdiff_t lanes = std::min( end - begin, LANES );
+   const __m256i mask = _mm256_cmpgt_epi32( _mm256_set1_epi32( (int) lanes ), _mm256_set_epi32( 7, 6, 5, 4, 3, 2, 1, 0 ) );
+   const __m256i loaded = _mm256_maskload_epi32( (const int*) begin, mask );
+   begin += lanes;
+   return( _mm256_blendv_epi8( _mm256_set1_epi32( -1 ), loaded, mask ) );
+  }
+//+----------------------------------------------------+
+//| AVX2:                    |
+//+----------------------------------------------------+
+void CSimdSort::SAvx2::MergeStore( uint32_t* &result, ptrdiff_t &rest, const __m256i v )
+  {
+   const ptrdiff_t lanes = std::min( rest, LANES );
+   _mm256_maskstore_epi32( (int*) result, _mm256_cmpgt_epi32( _mm256_set1_epi32( (int) lanes ), _mm256_set_epi32( 7, 6, 5, 4, 3, 2, 1, 0 ) ), v );
+   result += lanes;
+   rest -= lanes;
+  }
+//+----------------------------------------------------+
+//| AVX2:                  |
+//+----------------------------------------------------+
+const int* CSimdSort::SAvx2::PartitionTable()
+  {
+   struct STable
+     {
+      int            lanes[256 * LANES];
+                     STable()
+        {
+         for( int mask = 0; mask < 256; mask++ )
+           {
+            int position = 0;
+            for( int lane = 0; lane < LANES; lane++ )
+               if( !( mask & ( 1 << lane ) ) )
+                  lanes[mask * LANES + position++] = lane;
+            for( int lane = 0; lane < LANES; lane++ )
+               if( mask & ( 1 << lane ) )
+                  lanes[mask * LANES + position++] = lane;
+           }
+        }
+     };
+   static const STable table;
+   return( table.lanes );
+  }
+#endif
+//+----------------------------------------------------+
+//|    :  32-         |
+//|   ,     |
+//| - std::sort  std::merge                           |
+//+----------------------------------------------------+
+template<class IntType>
+struct SLeafSort
+  {
+   static void       Sort( IntType* begin, IntType* end ) { std::sort( begin, end ); }
+   static void       Merge( const IntType* a, const IntType* a_end, const IntType* b, const IntType* b_end, IntType* result ) { std::merge( a, a_end, b, b_end, result ); }
+  };
+template<>
+struct SLeafSort<uint32_t>
+  {
+   static void       Sort( uint32_t* begin, uint32_t* end ) { CSimdSort::Sort( begin, end ); }
+   static void       Merge( const uint32_t* a, const uint32_t* a_end, const uint32_t* b, const uint32_t* b_end, uint32_t* result ) { CSimdSort::Merge( a, a_end, b, b_end, result ); }
+  };
+//+----------------------------------------------------+
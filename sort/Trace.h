@@ -0,0 +1,131 @@
+//+----------------------------------------------------+
+//| Author: Maxim Ulyanov <ulyanov.maxim@gmail.com>    |
+//+----------------------------------------------------+
+//+----------------------------------------------------+
+//|                                    |
+//+----------------------------------------------------+
+//|          |
+//|  ,      |
+//| .  - JSON Chrome trace (Perfetto)        |
+//+----------------------------------------------------+
+class CTrace
+  {
+public:
+   static const size_t EVENTS = 64 * 1024;
+
+private:
+   //--- :      
+   struct SEvent
+     {
+      const char*    name;
+      unsigned long long start;
+      unsigned long long duration;
+     };
+   //---  :    ,      
+   struct SThread
+     {
+      size_t         id;
+      const char*    name;
+      std::atomic<size_t> written;
+      SEvent         events[EVENTS];
+     };
+   std::atomic<bool> m_enabled;
+   unsigned long long m_start;
+   boost::mutex      m_threads_sync;
+   std::vector<std::unique_ptr<SThread>> m_threads;
+
+public:
+   static CTrace    &Instance() { static CTrace trace; return( trace ); }
+   //---     
+   void              Enable() { m_start = CMetrics::Now(); m_enabled = true; }
+   bool              Enabled() const { return( m_enabled.load( std::memory_order_relaxed ) ); }
+   //---     
+   void              ThreadName( const char* name ) { if( Enabled() ) Thread().name = name; }
+   //---   , name -  
+   void              Add( const char* name, const unsigned long long start, const unsigned long long duration );
+   //---    
+   bool              Dump( const std::string &file_name );
+
+private:
+                     CTrace() : m_enabled( false ), m_start( 0 ) {}
+   SThread          &Thread();
+  };
+//+----------------------------------------------------+
+//|                                 |
+//+----------------------------------------------------+
+CTrace::SThread &CTrace::Thread()
+  {
+//---       
+   static thread_local SThread* thread = nullptr;
+   if( thread == nullptr )
+     {
+      std::unique_ptr<SThread> created( new SThread );
+      created->name = nullptr;
+      created->written = 0;
+      thread = created.get();
+      boost::lock_guard<boost::mutex> lock( m_threads_sync );
+      created->id = m_threads.size() + 1;
+      m_threads.push_back( std::move( created ) );
+     }
+   return( *thread );
+  }
+//+----------------------------------------------------+
+//|                                   |
+//+----------------------------------------------------+
+void CTrace::Add( const char* name, const unsigned long long start, const unsigned long long duration )
+  {
+   SThread &thread = Thread();
+   const size_t written = thread.written.load( std::memory_order_relaxed );
+   SEvent &event = thread.events[written % EVENTS];
+   event.name = name;
+   event.start = start;
+   event.duration = duration;
+   thread.written.store( written + 1, std::memory_order_release );
+  }
+//+----------------------------------------------------+
+//|                                                |
+//+----------------------------------------------------+
+bool CTrace::Dump( const std::string &file_name )
+  {
+   std::ofstream out( file_name.c_str() );
+   if( !out )
+      return( false );
+   boost::lock_guard<boost::mutex> lock( m_threads_sync );
+   out << "{ \"displayTimeUnit\": \"ms\", \"traceEvents\": [";
+   size_t dropped = 0;
+   bool first = true;
+   for( const auto &thread : m_threads )
+     {
+      //---   -  
+      out << ( first ? "" : "," ) << std::endl << "{ \"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": " << thread->id << ", \"args\": { \"name\": \"" << ( thread->name != nullptr ? thread->name : "thread" ) << " " << thread->id << "\" } }";
+      first = false;
+      //---   -   ,   -   X
+      const size_t written = thread->written.load( std::memory_order_acquire );
+      const size_t begin = written > EVENTS ? written - EVENTS : 0;
+      dropped += begin;
+      for( size_t index = begin; index < written; index++ )
+        {
+         const SEvent &event = thread->events[index % EVENTS];
+         out << "," << std::endl << "{ \"name\": \"" << event.name << "\", \"ph\": \"X\", \"pid\": 1, \"tid\": " << thread->id;
+         out << ", \"ts\": " << ( event.start >= m_start ? event.start - m_start : 0 ) << ", \"dur\": " << event.duration << " }";
+        }
+     }
+   out << std::endl << "], \"otherData\": { \"dropped_events\": " << dropped << " } }" << std::endl;
+   return( !out.fail() );
+  }
+//+----------------------------------------------------+
+//|                                  |
+//+----------------------------------------------------+
+//|       |
+//+----------------------------------------------------+
+class CTraceScope
+  {
+private:
+   const char*       m_name;
+   const unsigned long long m_start;
+
+public:
+                     CTraceScope( const char* name ) : m_name( name ), m_start( CTrace::Instance().Enabled() ? CMetrics::Now() : 0 ) {}
+                    ~CTraceScope() { if( m_start != 0 ) CTrace::Instance().Add( m_name, m_start, CMetrics::Now() - m_start ); }
+  };
+//+----------------------------------------------------+
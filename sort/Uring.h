@@ -0,0 +1,286 @@
+//+----------------------------------------------------+
+//| Author: Maxim Ulyanov <ulyanov.maxim@gmail.com>    |
+//+----------------------------------------------------+
+//+----------------------------------------------------+
+//|  io_uring                 |
+//+----------------------------------------------------+
+class CUring
+  {
+private:
+   //---  
+   int               m_fd;
+#ifdef __linux__
+   //---  
+   void*             m_sq_ring;
+   size_t            m_sq_ring_size;
+   unsigned         *m_sq_head;
+   unsigned         *m_sq_tail;
+   unsigned         *m_sq_mask;
+   unsigned         *m_sq_array;
+   unsigned          m_sq_entries;
+   io_uring_sqe     *m_sqes;
+   size_t            m_sqes_size;
+   //---  
+   void*             m_cq_ring;
+   size_t            m_cq_ring_size;
+   unsigned         *m_cq_head;
+   unsigned         *m_cq_tail;
+   unsigned         *m_cq_mask;
+   io_uring_cqe     *m_cqes;
+   //--- ,   ,     
+   unsigned          m_unsubmitted;
+   //--- ,      
+   unsigned          m_inflight;
+#endif
+
+public:
+                     CUring();
+                    ~CUring();
+   //---      
+   bool              Init( const unsigned entries );
+   bool              Ready() const { return( m_fd >= 0 ); }
+   void              Close();
+   //---  /  , tag   
+   bool              Read( const int file, char* buffer, const size_t size, const long long offset, const unsigned long long tag );
+   bool              Write( const int file, const char* buffer, const size_t size, const long long offset, const unsigned long long tag );
+   //---    ,       
+   bool              Submit();
+   //---    :  -    -errno
+   bool              Complete( unsigned long long &tag, int &result );
+   //---   :    ,    
+   unsigned          Inflight() const;
+   //--- io_uring  
+   static bool       Available();
+
+private:
+#ifdef __linux__
+   bool              Queue( const int opcode, const int file, const char* buffer, const size_t size, const long long offset, const unsigned long long tag );
+#endif
+  };
+//+----------------------------------------------------+
+//|                                         |
+//+----------------------------------------------------+
+CUring::CUring() : m_fd( -1 )
+  {
+#ifdef __linux__
+   m_sq_ring = m_cq_ring = MAP_FAILED;
+   m_sqes = (io_uring_sqe*) MAP_FAILED;
+   m_sq_ring_size = m_cq_ring_size = m_sqes_size = 0;
+   m_unsubmitted = m_inflight = 0;
+#endif
+  }
+//+----------------------------------------------------+
+//|                                          |
+//+----------------------------------------------------+
+CUring::~CUring()
+  {
+   Close();
+  }
+//+----------------------------------------------------+
+//|                                     |
+//+----------------------------------------------------+
+bool CUring::Init( const unsigned entries )
+  {
+   Close();
+#ifdef __linux__
+   io_uring_params params;
+   memset( &params, 0, sizeof( params ) );
+   if( ( m_fd = (int) syscall( __NR_io_uring_setup, entries, &params ) ) < 0 )
+      return( false );
+//--- IORING_OP_READ/WRITE    IORING_FEAT_RW_CUR_POS (5.6)
+   if( !( params.features & IORING_FEAT_RW_CUR_POS ) )
+     {
+      Close();
+      return( false );
+     }
+//---  ,  IORING_FEAT_SINGLE_MMAP     
+   m_sq_ring_size = params.sq_off.array + params.sq_entries * sizeof( unsigned );
+   m_cq_ring_size = params.cq_off.cqes + params.cq_entries * sizeof( io_uring_cqe );
+   if( params.features & IORING_FEAT_SINGLE_MMAP )
+      m_sq_ring_size = m_cq_ring_size = std::max( m_sq_ring_size, m_cq_ring_size );
+   m_sq_ring = mmap( nullptr, m_sq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, m_fd, IORING_OFF_SQ_RING );
+   if( m_sq_ring == MAP_FAILED )
+     {
+      Close();
+      return( false );
+     }
+   if( params.features & IORING_FEAT_SINGLE_MMAP )
+      m_cq_ring = m_sq_ring;
+   else
+      if( ( m_cq_ring = mmap( nullptr, m_cq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, m_fd, IORING_OFF_CQ_RING ) ) == MAP_FAILED )
+        {
+         Close();
+         return( false );
+        }
+   m_sqes_size = params.sq_entries * sizeof( io_uring_sqe );
+   m_sqes = (io_uring_sqe*) mmap( nullptr, m_sqes_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, m_fd, IORING_OFF_SQES );
+   if( m_sqes == MAP_FAILED )
+     {
+      Close();
+      return( false );
+     }
+//---    
+   char* sq = (char*) m_sq_ring;
+   m_sq_head = (unsigned*) ( sq + params.sq_off.head );
+   m_sq_tail = (unsigned*) ( sq + params.sq_off.tail );
+   m_sq_mask = (unsigned*) ( sq + params.sq_off.ring_mask );
+   m_sq_array = (unsigned*) ( sq + params.sq_off.array );
+   m_sq_entries = params.sq_entries;
+   char* cq = (char*) m_cq_ring;
+   m_cq_head = (unsigned*) ( cq + params.cq_off.head );
+   m_cq_tail = (unsigned*) ( cq + params.cq_off.tail );
+   m_cq_mask = (unsigned*) ( cq + params.cq_off.ring_mask );
+   m_cqes = (io_uring_cqe*) ( cq + params.cq_off.cqes );
+   return( true );
+#else
+   return( false );
+#endif
+  }
+//+----------------------------------------------------+
+//|                                     |
+//+----------------------------------------------------+
+void CUring::Close()
+  {
+#ifdef __linux__
+   if( m_sqes != MAP_FAILED )
+      munmap( m_sqes, m_sqes_size );
+   if( m_cq_ring != MAP_FAILED && m_cq_ring != m_sq_ring )
+      munmap( m_cq_ring, m_cq_ring_size );
+   if( m_sq_ring != MAP_FAILED )
+      munmap( m_sq_ring, m_sq_ring_size );
+   m_sq_ring = m_cq_ring = MAP_FAILED;
+   m_sqes = (io_uring_sqe*) MAP_FAILED;
+   m_unsubmitted = m_inflight = 0;
+   if( m_fd >= 0 )
+      close( m_fd );
+#endif
+   m_fd = -1;
+  }
+//+----------------------------------------------------+
+//|                            |
+//+----------------------------------------------------+
+bool CUring::Read( const int file, char* buffer, const size_t size, const long long offset, const unsigned long long tag )
+  {
+#ifdef __linux__
+   return( Queue( IORING_OP_READ, file, buffer, size, offset, tag ) );
+#else
+   return( false );
+#endif
+  }
+//+----------------------------------------------------+
+//|                            |
+//+----------------------------------------------------+
+bool CUring::Write( const int file, const char* buffer, const size_t size, const long long offset, const unsigned long long tag )
+  {
+#ifdef __linux__
+   return( Queue( IORING_OP_WRITE, file, buffer, size, offset, tag ) );
+#else
+   return( false );
+#endif
+  }
+#ifdef __linux__
+//+----------------------------------------------------+
+//|                            |
+//+----------------------------------------------------+
+bool CUring::Queue( const int opcode, const int file, const char* buffer, const size_t size, const long long offset, const unsigned long long tag )
+  {
+   if( m_fd < 0 )
+      return( false );
+//---     ,   
+   const unsigned tail = *m_sq_tail;
+   if( tail - __atomic_load_n( m_sq_head, __ATOMIC_ACQUIRE ) >= m_sq_entries )
+      return( false );
+   const unsigned index = tail & *m_sq_mask;
+   io_uring_sqe &sqe = m_sqes[index];
+   memset( &sqe, 0, sizeof( sqe ) );
+   sqe.opcode = (unsigned char) opcode;
+   sqe.fd = file;
+   sqe.addr = (unsigned long long) buffer;
+   sqe.len = (unsigned) size;
+   sqe.off = (unsigned long long) offset;
+   sqe.user_data = tag;
+   m_sq_array[index] = index;
+//---        
+   __atomic_store_n( m_sq_tail, tail + 1, __ATOMIC_RELEASE );
+   m_unsubmitted++;
+   return( true );
+  }
+#endif
+//+----------------------------------------------------+
+//|                                |
+//+----------------------------------------------------+
+bool CUring::Submit()
+  {
+#ifdef __linux__
+   while( m_unsubmitted > 0 )
+     {
+      const int submitted = (int) syscall( __NR_io_uring_enter, m_fd, m_unsubmitted, 0, 0, nullptr, 0 );
+      if( submitted < 0 )
+        {
+         if( errno == EINTR || errno == EAGAIN || errno == EBUSY )
+            continue;
+         //---      io_uring_enter:    ,    
+         __atomic_store_n( m_sq_tail, __atomic_load_n( m_sq_head, __ATOMIC_ACQUIRE ), __ATOMIC_RELEASE );
+         m_unsubmitted = 0;
+         return( false );
+        }
+      m_unsubmitted -= std::min<unsigned>( submitted, m_unsubmitted );
+      m_inflight += submitted;
+     }
+   return( true );
+#else
+   return( false );
+#endif
+  }
+//+----------------------------------------------------+
+//|                 |
+//+----------------------------------------------------+
+bool CUring::Complete( unsigned long long &tag, int &result )
+  {
+#ifdef __linux__
+//---     
+   if( m_fd < 0 || m_inflight == 0 )
+      return( false );
+   for( ;; )
+     {
+      //---     ,  - 
+      const unsigned head = *m_cq_head;
+      if( head != __atomic_load_n( m_cq_tail, __ATOMIC_ACQUIRE ) )
+        {
+         const io_uring_cqe &cqe = m_cqes[head & *m_cq_mask];
+         tag = cqe.user_data;
+         result = cqe.res;
+         __atomic_store_n( m_cq_head, head + 1, __ATOMIC_RELEASE );
+         m_inflight--;
+         return( true );
+        }
+      //---   ,    ;    ,     
+      //---   ,      -      
+      if( syscall( __NR_io_uring_enter, m_fd, 0, 1, IORING_ENTER_GETEVENTS, nullptr, 0 ) < 0 && errno != EINTR && errno != EAGAIN && errno != EBUSY )
+         usleep( 1000 );
+     }
+#else
+   return( false );
+#endif
+  }
+//+----------------------------------------------------+
+//|                          |
+//+----------------------------------------------------+
+unsigned CUring::Inflight() const
+  {
+#ifdef __linux__
+   return( m_inflight );
+#else
+   return( 0 );
+#endif
+  }
+//+----------------------------------------------------+
+//|  io_uring                         |
+//+----------------------------------------------------+
+bool CUring::Available()
+  {
+//---   io_uring   seccomp-
+   CUring uring;
+   return( uring.Init( 1 ) );
+  }
+//+----------------------------------------------------+
@@ -0,0 +1,270 @@
+//+----------------------------------------------------+
+//| Author: Maxim Ulyanov <ulyanov.maxim@gmail.com>    |
+//+----------------------------------------------------+
+//+----------------------------------------------------+
+//|       (Chase-Lev)   |
+//+----------------------------------------------------+
+//|        , |
+//|     ;   |
+//+----------------------------------------------------+
+template<class Item>
+class CWorkDeque
+  {
+public:
+   //---  ;  - ,  
+   static const long long CAPACITY = 1024;
+
+private:
+   //---   ()    ()
+   std::atomic<long long> m_top;
+   std::atomic<long long> m_bottom;
+   //---  
+   std::atomic<Item*> m_items[CAPACITY];
+
+public:
+                     CWorkDeque() : m_top( 0 ), m_bottom( 0 ) {}
+   //---  ; false -    
+   bool              Push( Item* item );
+   bool              Pop( Item* &item );
+   //---    ; false -      
+   bool              Steal( Item* &item );
+  };
+//+----------------------------------------------------+
+//|                          |
+//+----------------------------------------------------+
+template<class Item>
+bool CWorkDeque<Item>::Push( Item* item )
+  {
+   const long long bottom = m_bottom.load( std::memory_order_relaxed );
+   const long long top = m_top.load( std::memory_order_acquire );
+   if( bottom - top >= CAPACITY )
+      return( false );
+   m_items[bottom % CAPACITY].store( item, std::memory_order_relaxed );
+//---         
+   std::atomic_thread_fence( std::memory_order_release );
+   m_bottom.store( bottom + 1, std::memory_order_relaxed );
+   return( true );
+  }
+//+----------------------------------------------------+
+//|                 |
+//+----------------------------------------------------+
+template<class Item>
+bool CWorkDeque<Item>::Pop( Item* &item )
+  {
+   const long long bottom = m_bottom.load( std::memory_order_relaxed ) - 1;
+   m_bottom.store( bottom, std::memory_order_relaxed );
+   std::atomic_thread_fence( std::memory_order_seq_cst );
+   long long top = m_top.load( std::memory_order_relaxed );
+   if( top > bottom )
+     {
+      //---  
+      m_bottom.store( bottom + 1, std::memory_order_relaxed );
+      return( false );
+     }
+   item = m_items[bottom % CAPACITY].load( std::memory_order_relaxed );
+   if( top < bottom )
+      return( true );
+//---  :      
+   const bool taken = m_top.compare_exchange_strong( top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed );
+   m_bottom.store( bottom + 1, std::memory_order_relaxed );
+   return( taken );
+  }
+//+----------------------------------------------------+
+//|                                   |
+//+----------------------------------------------------+
+template<class Item>
+bool CWorkDeque<Item>::Steal( Item* &item )
+  {
+   long long top = m_top.load( std::memory_order_acquire );
+   std::atomic_thread_fence( std::memory_order_seq_cst );
+   const long long bottom = m_bottom.load( std::memory_order_acquire );
+   if( top >= bottom )
+      return( false );
+   item = m_items[top % CAPACITY].load( std::memory_order_relaxed );
+//---  ,          
+   return( m_top.compare_exchange_strong( top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed ) );
+  }
+//+----------------------------------------------------+
+//|         |
+//+----------------------------------------------------+
+//| Owner::*Handler  ,       |
+//|   Spawn;        |
+//|  ,         |
+//|   ,  ,   |
+//|                          |
+//+----------------------------------------------------+
+template<class Item, class Owner>
+class CWorkStealing
+  {
+public:
+   typedef void      ( Owner::*Handler )( CWorkStealing &tasks, const size_t worker, Item* begin, Item* end );
+   typedef std::shared_ptr<CWorkStealing> Ptr;
+
+private:
+   //---           , 
+   static const size_t SPIN_ROUNDS = 16;
+   static const long   PARK_TIMEOUT = 1000;
+   //--- :  ,      , 
+   struct STask
+     {
+      Item          *begin;
+      Item          *end;
+      std::atomic<size_t> pending;
+      STask         *parent;
+                     STask( Item* task_begin, Item* task_end, STask* task_parent ) : begin( task_begin ), end( task_end ), pending( 1 ), parent( task_parent ) {}
+     };
+   //---     
+   Owner            *m_owner;
+   const Handler     m_handler;
+   //---       ,    
+   std::unique_ptr<CWorkDeque<STask>[]> m_deques;
+   std::unique_ptr<STask*[]> m_current;
+   const size_t      m_workers;
+   //--- : ,   
+   STask             m_root;
+   //---       
+   std::atomic<bool> m_done;
+   std::atomic<size_t> m_parked;
+   boost::mutex      m_parked_sync;
+   boost::condition_variable m_parked_cond;
+
+public:
+                     CWorkStealing( Owner* owner, const Handler handler, const size_t workers );
+   size_t            Workers() const { return( m_workers ); }
+   //---       ;   ,   
+   void              Spawn( const size_t worker, Item* begin, Item* end );
+   //--- :    ,      0    
+   static void       Run( boost::asio::io_service &io, const Ptr &tasks );
+
+private:
+   //---         
+   void              Execute( const size_t worker, STask* task );
+   void              Finish( STask* task );
+   //---       ,   
+   void              Park();
+   //---  :  ,   
+   static void       Work( const Ptr tasks, const size_t worker );
+  };
+//+----------------------------------------------------+
+//|                                         |
+//+----------------------------------------------------+
+template<class Item, class Owner>
+CWorkStealing<Item, Owner>::CWorkStealing( Owner* owner, const Handler handler, const size_t workers ) : m_owner( owner ), m_handler( handler ), m_deques( new CWorkDeque<STask>[workers] ), m_current( new STask*[workers] ), m_workers( workers ), m_root( nullptr, nullptr, nullptr ), m_done( false ), m_parked( 0 )
+  {
+   for( size_t worker = 0; worker < workers; worker++ )
+      m_current[worker] = &m_root;
+  }
+//+----------------------------------------------------+
+//|                                    |
+//+----------------------------------------------------+
+template<class Item, class Owner>
+void CWorkStealing<Item, Owner>::Spawn( const size_t worker, Item* begin, Item* end )
+  {
+   STask* parent = m_current[worker];
+   STask* task = new STask( begin, end, parent );
+   parent->pending.fetch_add( 1, std::memory_order_relaxed );
+   if( !m_deques[worker].Push( task ) )
+     {
+      Execute( worker, task );
+      return;
+     }
+//---   ;      PARK_TIMEOUT
+   if( m_parked.load( std::memory_order_relaxed ) > 0 )
+      m_parked_cond.notify_one();
+  }
+//+----------------------------------------------------+
+//|                                     |
+//+----------------------------------------------------+
+template<class Item, class Owner>
+void CWorkStealing<Item, Owner>::Run( boost::asio::io_service &io, const Ptr &tasks )
+  {
+//---    :       
+   for( size_t worker = 1; worker < tasks->m_workers; worker++ )
+      io.post( boost::bind( &CWorkStealing::Work, tasks, worker ) );
+//---    
+   tasks->Finish( &tasks->m_root );
+   Work( tasks, 0 );
+  }
+//+----------------------------------------------------+
+//|                                    |
+//+----------------------------------------------------+
+template<class Item, class Owner>
+void CWorkStealing<Item, Owner>::Execute( const size_t worker, STask* task )
+  {
+//---       ,    
+   STask* current = m_current[worker];
+   m_current[worker] = task;
+   ( m_owner->*m_handler )( *this, worker, task->begin, task->end );
+   m_current[worker] = current;
+   Finish( task );
+  }
+//+----------------------------------------------------+
+//|                                    |
+//+----------------------------------------------------+
+template<class Item, class Owner>
+void CWorkStealing<Item, Owner>::Finish( STask* task )
+  {
+//---     
+   while( task->pending.fetch_sub( 1, std::memory_order_acq_rel ) == 1 )
+     {
+      STask* parent = task->parent;
+      if( parent == nullptr )
+        {
+         boost::lock_guard<boost::mutex> lock( m_parked_sync );
+         m_done.store( true, std::memory_order_release );
+         m_parked_cond.notify_all();
+         return;
+        }
+      delete task;
+      task = parent;
+     }
+  }
+//+----------------------------------------------------+
+//|                                  |
+//+----------------------------------------------------+
+template<class Item, class Owner>
+void CWorkStealing<Item, Owner>::Park()
+  {
+   boost::unique_lock<boost::mutex> lock( m_parked_sync );
+   if( m_done.load( std::memory_order_acquire ) )
+      return;
+   m_parked.fetch_add( 1, std::memory_order_relaxed );
+   m_parked_cond.timed_wait( lock, boost::posix_time::microseconds( PARK_TIMEOUT ) );
+   m_parked.fetch_sub( 1, std::memory_order_relaxed );
+  }
+//+----------------------------------------------------+
+//|                                          |
+//+----------------------------------------------------+
+template<class Item, class Owner>
+void CWorkStealing<Item, Owner>::Work( const Ptr tasks, const size_t worker )
+  {
+   size_t victim = worker;
+   size_t idle_rounds = 0;
+   while( !tasks->m_done.load( std::memory_order_acquire ) )
+     {
+      STask* task;
+      if( tasks->m_deques[worker].Pop( task ) )
+        {
+         tasks->Execute( worker, task );
+         idle_rounds = 0;
+         continue;
+        }
+      //---   :      
+      victim = ( victim + 1 ) % tasks->m_workers;
+      if( victim != worker )
+        {
+         if( tasks->m_deques[victim].Steal( task ) )
+           {
+            tasks->Execute( worker, task );
+            idle_rounds = 0;
+           }
+         continue;
+        }
+      //---    :   ,  
+      if( ++idle_rounds < SPIN_ROUNDS )
+         boost::this_thread::yield();
+      else
+         tasks->Park();
+     }
+  }
+//+----------------------------------------------------+
@@ -7,6 +7,21 @@
 //--- C
 #include <stdio.h>
 #include <stdlib.h>
+#include <stdint.h>
+#include <math.h>
+#ifndef _WIN32
+#include <unistd.h>
+#include <sys/mman.h>
+#endif
+#ifdef __linux__
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/syscall.h>
+#include <linux/io_uring.h>
+#endif
+#if defined( __GNUC__ ) && ( defined( __x86_64__ ) || defined( __i386__ ) )
+#include <immintrin.h>
+#endif
 //--- STL
 #include <chrono>
 #include <iostream>
@@ -15,8 +30,13 @@
 #include <string>
 #include <algorithm>
 #include <vector>
-#include <queue>
+#include <deque>
 #include <functional>
+#include <limits>
+#include <type_traits>
+#include <memory>
+#include <atomic>
+#include <stdexcept>
 //--- boost
 #include <boost/filesystem.hpp>
 #include <boost/asio.hpp>
@@ -27,17 +47,55 @@ const long long KB = 1024;
 const long long MB = 1024 * KB;
 const long long GB = 1024 * MB;
 //+----------------------------------------------------+
-//|                       |
+//|   :         |
+//|                         |
 //+----------------------------------------------------+
 const int CONCURRENCY_MULTIPLIER = 4;  
 //+----------------------------------------------------+
-//|                                     |
+//|  -                                |
 //+----------------------------------------------------+
-const long long RAM_MAX = 256 * MB;
+const int IO_THREADS = 2;
 //+----------------------------------------------------+
-//|                |
+//|   ,            |
 //+----------------------------------------------------+
-const int CHUNKS_MAX = 256;
+const int MEMORY_FRACTION = 4;
+//+----------------------------------------------------+
+//| ,          |
+//+----------------------------------------------------+
+const long long MEMORY_DEFAULT = 256 * MB;
+//+----------------------------------------------------+
+//|                             |
+//+----------------------------------------------------+
+const long long MEMORY_MIN = 1 * MB;
+//+----------------------------------------------------+
+//|    io_uring        |
+//+----------------------------------------------------+
+const int URING_DEPTH = 4;
+//+----------------------------------------------------+
+//|                     |
+//+----------------------------------------------------+
+const int SPLIT_BUFFERS = 6;
+//+----------------------------------------------------+
+//|                 |
+//+----------------------------------------------------+
+const long long MERGE_BUFFER_MIN = 64 * KB;
+//+----------------------------------------------------+
+//|   ,          |
+//+----------------------------------------------------+
+const long long MERGE_RUN_BUFFER = 4 * MB;
+//+----------------------------------------------------+
+//|  -       |
+//|                     |
+//+----------------------------------------------------+
+const double MERGE_IO_COST = 0.25;
+//+----------------------------------------------------+
+//|             |
+//+----------------------------------------------------+
+const int MERGE_SAMPLES = 16;
+//+----------------------------------------------------+
+//|             |
+//+----------------------------------------------------+
+const long long SELECT_BLOCK = 4 * MB;
 //+----------------------------------------------------+
 //| Timer, ms                                          |
 //+----------------------------------------------------+
@@ -64,21 +122,279 @@ public:
                     ~CAutoTimer() { std::cout << m_name << " completed in " << m_timer.End() << " ms" << std::endl; }
   };
 //--- 
+#include "Metrics.h"
+#include "Trace.h"
 #include "BinFile.h"
+#include "MemoryBudget.h"
+#include "Uring.h"
 #include "BufferedAsyncFile.h"
+#include "Record.h"
+#include "RunCodec.h"
 #include "DataChunk.h"
+#include "LoserTree.h"
+#include "WorkDeque.h"
+#include "SimdSort.h"
 #include "ParallelSort.h"
 #include "ExternalSort.h"
 //+----------------------------------------------------+
+//|                           |
+//+----------------------------------------------------+
+enum EnSortAlgorithm
+  {
+   SORT_QUICK = 0,
+   SORT_LINEAR_MERGE,
+   SORT_RADIX,
+   SORT_SAMPLE
+  };
+//+----------------------------------------------------+
+//|                                            |
+//+----------------------------------------------------+
+enum EnKeyType
+  {
+   KEY_U32 = 0,
+   KEY_U64,
+   KEY_I32,
+   KEY_I64,
+   KEY_F32,
+   KEY_F64
+  };
+//+----------------------------------------------------+
+//|  ,          |
+//+----------------------------------------------------+
+const size_t RECORD_WIDTHS[] = { 16, 32, 64, 128 };
+//+----------------------------------------------------+
+//|                                    |
+//+----------------------------------------------------+
+struct SParameters
+  {
+   std::string       input_file_name;
+   std::string       output_file_name;
+   EnSortAlgorithm   sort_algorithm;
+   //---  
+   EnRunGeneration   run_generation;
+   //---  , 0 -    
+   long long         memory_size;
+   //---  -:  CBinFile::MODE_URING, CBinFile::MODE_DIRECT
+   int               io_mode;
+   //---       
+   bool              input_mmap;
+   //---  
+   bool              compress_runs;
+   //---  
+   EnKeyType         key_type;
+   //---   (0 -    )     
+   size_t            record_size;
+   size_t            key_offset;
+   //---    ,  -  
+   std::string       metrics_file_name;
+   //---   ,  -  
+   std::string       trace_file_name;
+   //---   
+   std::vector<std::string> tmp_dirs;
+   //---   
+   EnReduce          reduce;
+   //---    (  ) ,  size_t - 
+   size_t            limit;
+                     SParameters() : sort_algorithm( SORT_QUICK ), run_generation( RUNS_SORT ), memory_size( 0 ), io_mode( CBinFile::MODE_URING ), input_mmap( false ), compress_runs( false ), key_type( KEY_U32 ), record_size( 0 ), key_offset( 0 ), reduce( REDUCE_NONE ), limit( std::numeric_limits<size_t>::max() ) {}
+   //---     
+   size_t            KeySize() const { return( ( key_type == KEY_U64 || key_type == KEY_I64 || key_type == KEY_F64 ) ? 8 : 4 ); }
+   size_t            ItemSize() const { return( record_size > 0 ? record_size : KeySize() ); }
+  };
+//+----------------------------------------------------+
+//|     KB, MB  GB    |
+//+----------------------------------------------------+
+bool size_parse( const std::string &value, long long &size )
+  {
+   std::stringstream value_s( value );
+   std::string unit;
+   value_s >> size;
+   if( value_s.fail() || size <= 0 )
+      return( false );
+   value_s >> unit;
+//---   - 
+   if( unit.empty() || unit == "B" )
+      return( true );
+   if( unit == "KB" || unit == "K" )
+      size *= KB;
+   else
+      if( unit == "MB" || unit == "M" )
+         size *= MB;
+      else
+         if( unit == "GB" || unit == "G" )
+            size *= GB;
+         else
+            return( false );
+   return( true );
+  }
+//+----------------------------------------------------+
 //| Parameters                                         |
 //+----------------------------------------------------+
-bool parameters( const char* input_file_name_arg, const char* output_file_name_arg, std::string &input_file_name, std::string &output_file_name )
+bool parameters( int argc, char** argv, SParameters &params )
   {
-   if( input_file_name_arg == NULL || output_file_name_arg == NULL )
+   std::vector<std::string> names;
+   for( int arg_index = 1; arg_index < argc; arg_index++ )
+     {
+      const std::string arg( argv[arg_index] );
+      //---  
+      if( arg.compare( 0, 2, "--" ) != 0 )
+        {
+         names.push_back( arg );
+         continue;
+        }
+      //---   -   ,   
+      if( arg == "--unique" || arg == "--count" )
+        {
+         const EnReduce reduce = ( arg == "--unique" ) ? REDUCE_UNIQUE : REDUCE_COUNT;
+         if( params.reduce != REDUCE_NONE && params.reduce != reduce )
+            return( false );
+         params.reduce = reduce;
+         continue;
+        }
+      //---     
+      if( arg_index + 1 >= argc )
+         return( false );
+      const std::string value( argv[++arg_index] );
+      if( arg == "--sort" )
+        {
+         if( value == "quick" )
+            params.sort_algorithm = SORT_QUICK;
+         else
+            if( value == "merge" )
+               params.sort_algorithm = SORT_LINEAR_MERGE;
+            else
+               if( value == "radix" )
+                  params.sort_algorithm = SORT_RADIX;
+               else
+                  if( value == "sample" )
+                     params.sort_algorithm = SORT_SAMPLE;
+                  else
+                     return( false );
+         continue;
+        }
+      if( arg == "--memory" )
+        {
+         if( !size_parse( value, params.memory_size ) || params.memory_size < MEMORY_MIN )
+            return( false );
+         continue;
+        }
+      if( arg == "--runs" )
+        {
+         if( value == "sort" )
+            params.run_generation = RUNS_SORT;
+         else
+            if( value == "replacement" )
+               params.run_generation = RUNS_REPLACEMENT;
+            else
+               return( false );
+         continue;
+        }
+      if( arg == "--io" )
+        {
+         if( value == "stdio" )
+            params.io_mode = CBinFile::MODE_NONE;
+         else
+            if( value == "uring" )
+               params.io_mode = CBinFile::MODE_URING;
+            else
+               if( value == "direct" )
+                  params.io_mode = CBinFile::MODE_URING | CBinFile::MODE_DIRECT;
+               else
+                  return( false );
+         continue;
+        }
+      if( arg == "--input" )
+        {
+         if( value == "read" )
+            params.input_mmap = false;
+         else
+            if( value == "mmap" )
+               params.input_mmap = true;
+            else
+               return( false );
+         continue;
+        }
+      if( arg == "--compress" )
+        {
+         if( value == "none" )
+            params.compress_runs = false;
+         else
+            if( value == "delta" )
+               params.compress_runs = true;
+            else
+               return( false );
+         continue;
+        }
+      if( arg == "--type" )
+        {
+         const char* types[] = { "u32", "u64", "i32", "i64", "f32", "f64" };
+         const char** type = std::find( std::begin( types ), std::end( types ), value );
+         if( type == std::end( types ) )
+            return( false );
+         params.key_type = EnKeyType( type - std::begin( types ) );
+         continue;
+        }
+      if( arg == "--record" || arg == "--key-offset" )
+        {
+         std::stringstream value_s( value );
+         long long number = -1;
+         value_s >> number;
+         if( value_s.fail() || !value_s.eof() || number < 0 )
+            return( false );
+         ( arg == "--record" ? params.record_size : params.key_offset ) = (size_t) number;
+         continue;
+        }
+      if( arg == "--limit" )
+        {
+         std::stringstream value_s( value );
+         long long number = 0;
+         value_s >> number;
+         if( value_s.fail() || !value_s.eof() || number <= 0 )
+            return( false );
+         params.limit = (size_t) number;
+         continue;
+        }
+      if( arg == "--metrics" )
+        {
+         params.metrics_file_name = value;
+         continue;
+        }
+      if( arg == "--trace" )
+        {
+         params.trace_file_name = value;
+         continue;
+        }
+      if( arg == "--tmp-dir" )
+        {
+         params.tmp_dirs.push_back( value );
+         continue;
+        }
+      //---  
       return( false );
+     }
+//---      ,  -     
+   if( params.record_size > 0 )
+     {
+      if( std::find( std::begin( RECORD_WIDTHS ), std::end( RECORD_WIDTHS ), params.record_size ) == std::end( RECORD_WIDTHS ) )
+         return( false );
+      if( params.key_type != KEY_U32 && params.key_type != KEY_U64 )
+         return( false );
+      if( params.key_offset + params.KeySize() > params.record_size )
+         return( false );
+      //---     ,   
+      if( params.compress_runs )
+         return( false );
+      //---      ,   
+      if( params.reduce == REDUCE_COUNT )
+         return( false );
+     }
+   else
+      if( params.key_offset > 0 )
+         return( false );
 //--- name
-   input_file_name = input_file_name_arg;
-   output_file_name = output_file_name_arg;
+   if( names.size() != 2 )
+      return( false );
+   params.input_file_name = names[0];
+   params.output_file_name = names[1];
    return( true );
   }
 //+----------------------------------------------------+
@@ -86,14 +402,30 @@ bool parameters( const char* input_file_name_arg, const char* output_file_name_a
 //+----------------------------------------------------+
 void usage()
   {
-   std::cout << "Usage: external_sort <input_file_name> <output_file_name>" << std::endl;
+   std::cout << "Usage: external_sort [options] <input_file_name> <output_file_name>" << std::endl;
    std::cout << '\t' << "input_file_name - name of the input file" << std::endl;
    std::cout << '\t' << "output_file_name - name of the output file" << std::endl;
+   std::cout << "Options:" << std::endl;
+   std::cout << '\t' << "--sort quick|merge|radix|sample - in-memory sort algorithm, sample sorts in place and doubles the run length (default quick)" << std::endl;
+   std::cout << '\t' << "--runs sort|replacement - chunk generation: sort memory-sized buffers or replacement selection (default sort)" << std::endl;
+   std::cout << '\t' << "--io stdio|uring|direct - file I/O: stdio in pool threads, io_uring, or io_uring with O_DIRECT (default uring, falls back to stdio)" << std::endl;
+   std::cout << '\t' << "--input read|mmap - read the input file or sort straight from its memory mapping, for inputs in page cache (default read)" << std::endl;
+   std::cout << '\t' << "--compress none|delta - chunk files: raw or delta + bit-packed blocks with a block index, bare keys only (default none)" << std::endl;
+   std::cout << '\t' << "--type u32|u64|i32|i64|f32|f64 - key type: unsigned, signed integer or IEEE-754 float of 32 or 64 bits (default u32)" << std::endl;
+   std::cout << '\t' << "--record 16|32|64|128 - sort fixed-width records of this many bytes instead of bare keys, record keys are u32 or u64" << std::endl;
+   std::cout << '\t' << "--key-offset <bytes> - offset of the key inside a record (default 0)" << std::endl;
+   std::cout << '\t' << "--memory <size> - memory budget for data buffers, f.e. 512MB or 4GB (default 1/" << MEMORY_FRACTION << " of available memory)" << std::endl;
+   std::cout << '\t' << "--unique - keep one item per key: equal keys collapse in every chunk and while merging" << std::endl;
+   std::cout << '\t' << "--count - write (key, 64-bit count) pairs of distinct keys, bare keys only; combine with --compress delta to shrink chunks of repeated keys" << std::endl;
+   std::cout << '\t' << "--limit <n> - write only the first n items (pairs with --count) of the sorted output; small n selects them in one pass without chunk files" << std::endl;
+   std::cout << '\t' << "--tmp-dir <dir> - directory for chunk files, repeat to stripe chunks round-robin over several disks (default next to the input file)" << std::endl;
+   std::cout << '\t' << "--metrics <file> - write a JSON report: per-phase time, bytes read and written, async wait histograms, sort and merge throughput, memory peak" << std::endl;
+   std::cout << '\t' << "--trace <file> - record read, write, sort and merge tasks and async I/O stalls of every thread, write them as Chrome trace JSON (chrome://tracing, ui.perfetto.dev)" << std::endl;
   }
 //+----------------------------------------------------+
 //|                                       |
 //+----------------------------------------------------+
-bool file_check( const std::string &file_name )
+bool file_check( const std::string &file_name, const size_t item_size )
   {
 //---   
    if( !boost::filesystem::exists( file_name ) )
@@ -104,25 +436,187 @@ bool file_check( const std::string &file_name )
 //---  
    long long file_size = boost::filesystem::file_size( file_name );
 //---      
-   if( file_size % sizeof( unsigned ) != 0 )
+   if( file_size % item_size != 0 )
      {
-      std::cerr << "file size is not a multiple of unsigned 32bit integer size (" << file_size << ")" << std::endl;
+      std::cerr << "file size is not a multiple of the item size " << item_size << " (" << file_size << ")" << std::endl;
       return( false );
      }
-//---     16 Gb
-   if( file_size > 16 * GB )
+//--- ok
+   return( true );
+  }
+//+----------------------------------------------------+
+//|                     |
+//+----------------------------------------------------+
+bool dir_check( const std::string &dir_name )
+  {
+   boost::system::error_code error;
+   if( !boost::filesystem::is_directory( dir_name, error ) )
      {
-      std::cerr << "file size exceeds maximum size of 16 GB (" << file_size << ")" << std::endl;
+      std::cerr << "directory is not exist " << dir_name << std::endl;
       return( false );
      }
-//---   
-   if( file_size / ( RAM_MAX / 4 ) > CHUNKS_MAX )
+   return( true );
+  }
+//+----------------------------------------------------+
+//|  ,                     |
+//+----------------------------------------------------+
+long long memory_available()
+  {
+   long long memory = 0;
+#ifdef _WIN32
+   MEMORYSTATUSEX status;
+   status.dwLength = sizeof( status );
+   if( GlobalMemoryStatusEx( &status ) )
+      memory = (long long) status.ullTotalPhys;
+#else
+   const long pages = sysconf( _SC_PHYS_PAGES );
+   const long page_size = sysconf( _SC_PAGE_SIZE );
+   if( pages > 0 && page_size > 0 )
+      memory = (long long) pages * page_size;
+//---     cgroup (v2  v1),  v2    "max"
+   const char* limit_files[] = { "/sys/fs/cgroup/memory.max", "/sys/fs/cgroup/memory/memory.limit_in_bytes" };
+   for( const char* limit_file : limit_files )
      {
-      std::cerr << "file size exceeds maximum size of " << CHUNKS_MAX * RAM_MAX / 4 << " (" << file_size << ")" <<std::endl;
-      return( false );
+      std::ifstream limit_s( limit_file );
+      long long limit = 0;
+      if( limit_s >> limit && limit > 0 && ( memory == 0 || limit < memory ) )
+         memory = limit;
+     }
+#endif
+   return( memory );
+  }
+//+----------------------------------------------------+
+//|                                        |
+//+----------------------------------------------------+
+long long memory_budget( const SParameters &params )
+  {
+   if( params.memory_size > 0 )
+      return( params.memory_size );
+//---   -   
+   const long long memory = memory_available();
+   if( memory <= 0 )
+      return( MEMORY_DEFAULT );
+   return( std::max( memory / MEMORY_FRACTION, MEMORY_MIN ) );
+  }
+//+----------------------------------------------------+
+//|  :           |
+//+----------------------------------------------------+
+void service_run( boost::asio::io_service *service, const char* name )
+  {
+   CTrace::Instance().ThreadName( name );
+   service->run();
+  }
+//+----------------------------------------------------+
+//|        |
+//+----------------------------------------------------+
+template<class IntType, class ParallelSort>
+void external_sort( const SParameters &params )
+  {
+//---   :   -    , -
+//---             
+   int cpu_threads = (int) boost::thread::physical_concurrency();
+   if( cpu_threads <= 0 )
+      cpu_threads = std::max( 1, (int) boost::thread::hardware_concurrency() );
+   int concurrency_level = cpu_threads * CONCURRENCY_MULTIPLIER;
+   boost::asio::io_service io;
+   boost::asio::io_service cpu;
+   CMemoryBudget memory( (size_t) std::min<unsigned long long>( memory_budget( params ), std::numeric_limits<size_t>::max() ) );
+   std::cout << "memory budget " << memory.Limit() / MB << " MB" << std::endl;
+//---   io_uring   stdio
+   int io_mode = params.io_mode;
+   if( ( io_mode & CBinFile::MODE_URING ) && !CUring::Available() )
+      io_mode = CBinFile::MODE_NONE;
+   if( params.input_mmap )
+      io_mode |= CBinFile::MODE_MMAP;
+   std::cout << "file I/O " << ( ( io_mode & CBinFile::MODE_DIRECT ) ? "io_uring, O_DIRECT" : ( io_mode & CBinFile::MODE_URING ) ? "io_uring" : "stdio" ) << std::endl;
+   std::cout << "threads " << cpu_threads << " sort, " << IO_THREADS << " I/O" << std::endl;
+   CExternalSort<IntType, ParallelSort> ext_sort( io, cpu, memory, concurrency_level, params.run_generation, io_mode, params.compress_runs, params.tmp_dirs, params.reduce, params.limit );
+//---   ,  ,   
+   std::unique_ptr<boost::asio::io_service::work> io_work( new boost::asio::io_service::work( io ) );
+   std::unique_ptr<boost::asio::io_service::work> cpu_work( new boost::asio::io_service::work( cpu ) );
+   boost::thread_group threads_pool;
+   if( !params.trace_file_name.empty() )
+     {
+      CTrace::Instance().Enable();
+      CTrace::Instance().ThreadName( "main" );
+     }
+   for( int thread_index = 0; thread_index < IO_THREADS; thread_index++ )
+      threads_pool.create_thread( boost::bind( &service_run, &io, "io" ) );
+   for( int thread_index = 0; thread_index < cpu_threads; thread_index++ )
+      threads_pool.create_thread( boost::bind( &service_run, &cpu, "cpu" ) );
+//---         ,    
+   ext_sort.Sort( params.input_file_name, params.output_file_name );
+   io_work.reset();
+   cpu_work.reset();
+//--- TODO:   
+   threads_pool.join_all();
+   std::cout << "memory budget peak usage " << memory.Peak() / MB << " MB" << std::endl;
+//---   
+   CMetrics::Instance().Memory( memory.Limit(), memory.Peak() );
+   if( !params.metrics_file_name.empty() && !CMetrics::Instance().Report( params.metrics_file_name ) )
+      std::cerr << "failed to write metrics to " << params.metrics_file_name << std::endl;
+   if( !params.trace_file_name.empty() && !CTrace::Instance().Dump( params.trace_file_name ) )
+      std::cerr << "failed to write trace to " << params.trace_file_name << std::endl;
+  }
+//+----------------------------------------------------+
+//|             |
+//+----------------------------------------------------+
+template<class IntType>
+void external_sort( const SParameters &params )
+  {
+   switch( params.sort_algorithm )
+     {
+      case SORT_LINEAR_MERGE:
+         external_sort<IntType, CParallelSortLinearMerge<IntType>>( params );
+         break;
+      case SORT_RADIX:
+         external_sort<IntType, CParallelRadixSort<IntType>>( params );
+         break;
+      case SORT_SAMPLE:
+         external_sort<IntType, CParallelSampleSort<IntType>>( params );
+         break;
+      default:
+         external_sort<IntType, CParallelQuickSort<IntType>>( params );
+         break;
+     }
+  }
+//+----------------------------------------------------+
+//|               |
+//+----------------------------------------------------+
+template<size_t WIDTH, class KeyType>
+void external_sort_records( const SParameters &params )
+  {
+   if( !SRecord<WIDTH, KeyType>::KeyOffset( params.key_offset ) )
+      throw std::invalid_argument( "key does not fit into the record" );
+   std::cout << "records " << WIDTH << " bytes, key offset " << params.key_offset << std::endl;
+   external_sort<SRecord<WIDTH, KeyType>>( params );
+  }
+//+----------------------------------------------------+
+//|     :     |
+//|                                    |
+//+----------------------------------------------------+
+template<class KeyType>
+void external_sort_unsigned( const SParameters &params )
+  {
+//---      
+   switch( params.record_size )
+     {
+      case 16:
+         external_sort_records<16, KeyType>( params );
+         break;
+      case 32:
+         external_sort_records<32, KeyType>( params );
+         break;
+      case 64:
+         external_sort_records<64, KeyType>( params );
+         break;
+      case 128:
+         external_sort_records<128, KeyType>( params );
+         break;
+      default:
+         external_sort<KeyType>( params );
+         break;
      }
-//--- ok
-   return( true );
   }
 //+----------------------------------------------------+
 //| Main function                                      |
@@ -131,37 +625,44 @@ int main(int argc,char** argv)
   {
    CAutoTimer timer( "external sort" );
 //---  
-   if( argc != 3 )
+   SParameters params;
+   if( !parameters( argc, argv, params ) )
      {
       std::cerr << "invalid parameters" << std::endl;
       usage();
       return( -1 );
      }
-   std::string input_file_name, output_file_name;
-   if( !parameters( argv[1], argv[2], input_file_name, output_file_name ) )
-     {
-      std::cerr << "failed to read parameters" << std::endl;
-      return( -1 );
-     }
 //---  
-   if( !file_check( input_file_name ) )
+   if( !file_check( params.input_file_name, params.ItemSize() ) )
       return( -1 );
+   for( const auto &dir_name : params.tmp_dirs )
+      if( !dir_check( dir_name ) )
+         return( -1 );
 //--- 
    try
      {
-      //---   
-      int concurrency_level = boost::thread::hardware_concurrency() * CONCURRENCY_MULTIPLIER;
-      boost::asio::io_service io;
-      CExternalSort<> ext_sort( io, concurrency_level );
-      io.post( boost::bind( &CExternalSort<>::Sort, &ext_sort, input_file_name, output_file_name ) );
-      //---   
-      boost::thread_group threads_pool;
-      for( int thread_index = 0; thread_index < concurrency_level; thread_index++ )
-         threads_pool.create_thread( boost::bind( &boost::asio::io_service::run, &io ) );
-      //--- 
-      io.run();
-      //--- TODO:   
-      threads_pool.join_all();
+      //---      
+      switch( params.key_type )
+        {
+         case KEY_U64:
+            external_sort_unsigned<uint64_t>( params );
+            break;
+         case KEY_I32:
+            external_sort<int32_t>( params );
+            break;
+         case KEY_I64:
+            external_sort<int64_t>( params );
+            break;
+         case KEY_F32:
+            external_sort<SFloatKey<float>>( params );
+            break;
+         case KEY_F64:
+            external_sort<SFloatKey<double>>( params );
+            break;
+         default:
+            external_sort_unsigned<uint32_t>( params );
+            break;
+        }
      }
    catch( std::exception &ex )
      {